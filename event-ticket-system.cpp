@@ -1,1081 +1,7745 @@
-#include <iostream>
-#include <vector>
-#include <regex>
-#include <cctype>
-#include <iomanip>
-#include <limits>
-#include <fstream>
-#include <sstream>
-#include <map>
-#include <string>
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <termios.h>
-#include <unistd.h>
-#endif
-#include <sys/stat.h>
-using namespace std;
-
-// =============== HELPER FUNCTIONS ===============
-void clearScreen() {
-    #ifdef _WIN32
-    system("cls");
-    #else
-    system("clear");
-    #endif
-}
-
-void waitForEnter() {
-    // Clear any existing input first
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    // Wait for exactly one Enter press
-    while (cin.get() != '\n') {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-    }
-}
-
-void clearInput() {
-    cin.clear();
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-}
-
-void showScreenHeader(const string& title) {
-    clearScreen();
-    cout << "\n===== " << title << " =====" << endl;
-}
-
-string getlineinput(const string& prompt) {
-    string input;
-    cout << prompt;
-    getline(cin, input);
-    return input;
-}
-
-int getMenuChoice(const string& prompt, int minChoice, int maxChoice) {
-    string input;
-    while (true) {
-        cout << prompt;
-        getline(cin, input);
-        
-        // Skip empty input (just Enter pressed)
-        if (input.empty()) {
-            continue;
-        }
-        
-        // Check if input is numeric
-        bool isNumeric = true;
-        for (char c : input) {
-            if (!isdigit(c)) {
-                isNumeric = false;
-                break;
-            }
-        }
-        
-        if (!isNumeric) {
-            cout << "Invalid input! Please enter a number between " 
-                 << minChoice << " and " << maxChoice << ".\n";
-            continue;
-        }
-        
-        // Convert to integer
-        stringstream ss(input);
-        int choice;
-        ss >> choice;
-        
-        // Validate range
-        if (choice < minChoice || choice > maxChoice) {
-            cout << "Please enter a number between " 
-                 << minChoice << " and " << maxChoice << ".\n";
-            continue;
-        }
-        
-        return choice;
-    }
-}
-
-// =============== CORE FUNCTIONALITY ===============
-bool validdate(const string& date) {
-    // First check the format
-    regex datePattern("^(0[1-9]|[12][0-9]|3[01])-(0[1-9]|1[0-2])-\\d{4}$");
-    
-    if (!regex_match(date, datePattern)) {
-        cout << "Error: Date must be in DD-MM-YYYY format (e.g., 15-06-2025).\n";
-        return false;
-    }
-
-    // Extract components
-    int day = stoi(date.substr(0, 2));
-    int month = stoi(date.substr(3, 2));
-    int year = stoi(date.substr(6, 4));
-
-    // Check year (must be 2025 or later)
-    if (year < 2025) {
-        cout << "Invalid year! Events can only be created for 2025 or later.\n";
-        return false;
-    }
-
-    // Check month
-    if (month < 1 || month > 12) {
-        cout << "Invalid month! Month must be between 01 and 12.\n";
-        return false;
-    }
-
-    // Check day
-    if (day < 1 || day > 31) {
-        cout << "Invalid day! Day must be between 01 and 31.\n";
-        return false;
-    }
-
-    // Check months with 30 days
-    if ((month == 4 || month == 6 || month == 9 || month == 11) && day > 30) {
-        cout << "Invalid day! This month only has 30 days.\n";
-        return false;
-    }
-
-    // Check February
-    if (month == 2) {
-        bool isLeap = (year % 400 == 0) || (year % 100 != 0 && year % 4 == 0);
-        if (day > (isLeap ? 29 : 28)) {
-            cout << "Invalid day! February only has " << (isLeap ? 29 : 28) << " days in " << year << ".\n";
-            return false;
-        }
-    }
-
-    return true;
-}
-
-class Event {
-public:
-    int eventID;
-    string eventName;
-    string eventLocation;
-    string eventDate;
-    map<string, pair<float, int>> ticketTiers;
-    
-    Event(int id, string name, string location, string date) {
-        eventID = id;
-        eventName = name;
-        eventLocation = location;
-        eventDate = date;
-    }
-
-    void addTicketTier(string tierName, float price, int quantity) {
-        ticketTiers[tierName] = make_pair(price, quantity);
-    }
-
-    int getTotalTickets() const {
-        int total = 0;
-        for (const auto& tier : ticketTiers) {
-            total += tier.second.second;
-        }
-        return total;
-    }
-
-    void displayEvent() const {
-        cout << "\n===== Event Details =====\n";
-        cout << "Event ID: " << eventID << endl;
-        cout << "Event Name: " << eventName << endl;
-        cout << "Location: " << eventLocation << endl;
-        cout << "Date: " << eventDate << endl;
-        cout << "Available Tickets:\n";
-        for (const auto& tier : ticketTiers) {
-            cout << " - " << tier.first << ": $" << fixed << setprecision(2) 
-                 << tier.second.first << " (" << tier.second.second << " available)\n";
-        }
-        cout << "Total Tickets: " << getTotalTickets() << endl;
-        cout << "======================\n";
-    }
-};
-
-class User {
-public:
-    int UserId;
-    string UserName;
-
-    User(int id, string name) {
-        UserId = id;
-        UserName = name;
-    }
-
-    void displayUser() const {
-        cout << "\n---- User Information ----\n";
-        cout << "User ID: " << UserId << endl;
-        cout << "User Name: " << UserName << endl;
-        cout << "==============================" << endl;
-    }
-};
-
-class Booking {
-public:
-    int bookingId;
-    int userId;
-    int eventId;
-    int tickets;
-    float totalPrice;
-    string status;
-    string ticketTier;
-
-    Booking(int bId, int uId, int eId, int tic, float price, string tier) {
-        bookingId = bId;
-        userId = uId;
-        eventId = eId;
-        tickets = tic;
-        totalPrice = price;
-        status = "Confirmed";
-        ticketTier = tier;
-    }
-
-    void displayBooking() const {
-        cout << "\n----- Booking Details -----\n";
-        cout << "Booking ID: " << bookingId << endl;
-        cout << "Event ID: " << eventId << endl;
-        cout << "User ID: " << userId << endl;
-        cout << "Ticket Tier: " << ticketTier << endl;
-        cout << "Tickets: " << tickets << endl;
-        cout << "Total Price: $" << fixed << setprecision(2) << totalPrice << endl;
-        cout << "Status: " << status << endl;
-    }
-};
-
-// =============== DATA MANAGEMENT ===============
-void ensureFileExists(const string& filename) {
-    ifstream file(filename);
-    if (!file.good()) {
-        ofstream createFile(filename);
-        createFile.close();
-    }
-}
-
-void initializeDataFiles() {
-    ensureFileExists("users.txt");
-    ensureFileExists("events.txt");
-    ensureFileExists("bookings.txt");
-}
-
-void saveUsers(const vector<User>& Userlist) {
-    ofstream outfile("users.txt");
-    if (!outfile) {
-        cerr << "Error saving users\n";
-        return;
-    }
-    for (const auto& user : Userlist) {
-        outfile << user.UserId << "," << user.UserName << "\n";
-    }
-    outfile.close();
-}
-
-void saveEvents(const vector<Event>& eventlist) {
-    ofstream outfile("events.txt");
-    if (!outfile) {
-        cerr << "Error saving events\n";
-        return;
-    }
-    for (const auto& event : eventlist) {
-        outfile << event.eventID << ","
-                << event.eventName << ","
-                << event.eventLocation << ","
-                << event.eventDate;
-
-        for (const auto& tier : event.ticketTiers) {
-            outfile << "," << tier.first << ":" << fixed << setprecision(2) 
-                    << tier.second.first << ":" << tier.second.second;
-        }
-        outfile << "\n";
-    }
-    outfile.close();
-}
-
-void saveBookings(const vector<Booking>& bookings) {
-    ofstream outFile("bookings.txt");
-    if (!outFile) {
-        cerr << "Error saving bookings\n";
-        return;
-    }
-    for (const auto& booking : bookings) {
-        outFile << booking.bookingId << ","
-                << booking.userId << ","
-                << booking.eventId << ","
-                << booking.tickets << ","
-                << fixed << setprecision(2) << booking.totalPrice << ","
-                << booking.status << ","
-                << booking.ticketTier << "\n";
-    }
-    outFile.close();
-}
-
-vector<User> loadUsers() {
-    vector<User> Userlist;
-    ifstream inFile("users.txt");
-    string line;
-    while (getline(inFile, line)) {
-        size_t pos = line.find(',');
-        if (pos != string::npos) {
-            int id = stoi(line.substr(0, pos));
-            string name = line.substr(pos + 1);
-            Userlist.emplace_back(id, name);
-        }
-    }
-    return Userlist;
-}
-
-vector<Event> loadEvents() {
-    vector<Event> eventlist;
-    ifstream inFile("events.txt");
-    string line;
-
-    while (getline(inFile, line)) {
-        stringstream ss(line);
-        string token;
-        vector<string> tokens;
-        
-        while (getline(ss, token, ',')) {
-            tokens.push_back(token);
-        }
-        
-        if (tokens.size() >= 4) {
-            Event event(stoi(tokens[0]), tokens[1], tokens[2], tokens[3]);
-            for (size_t i = 4; i < tokens.size(); i++) {
-                size_t firstColon = tokens[i].find(':');
-                size_t secondColon = tokens[i].rfind(':');
-                if (firstColon != string::npos && secondColon != string::npos) {
-                    string tierName = tokens[i].substr(0, firstColon);
-                    float price = stof(tokens[i].substr(firstColon + 1, secondColon - firstColon - 1));
-                    int quantity = stoi(tokens[i].substr(secondColon + 1));
-                    event.addTicketTier(tierName, price, quantity);
-                }
-            }
-            eventlist.push_back(event);
-        }
-    }
-    return eventlist;
-}
-
-vector<Booking> loadBookings() {
-    vector<Booking> bookings;
-    ifstream inFile("bookings.txt");
-    if (!inFile) return bookings;
-
-    string line;
-    while (getline(inFile, line)) {
-        if (line.empty() || line[0] == '#') continue;
-
-        vector<string> tokens;
-        string token;
-        size_t start = 0;
-        size_t end = line.find(',');
-        
-        while (end != string::npos) {
-            token = line.substr(start, end - start);
-            tokens.push_back(token);
-            start = end + 1;
-            end = line.find(',', start);
-        }
-        tokens.push_back(line.substr(start));
-
-        if (tokens.size() != 7) continue;
-
-        try {
-            bookings.emplace_back(
-                stoi(tokens[0]),
-                stoi(tokens[1]),
-                stoi(tokens[2]),
-                stoi(tokens[3]),
-                stof(tokens[4]),
-                tokens[6]
-            );
-            bookings.back().status = tokens[5];
-        } catch (...) {
-            continue;
-        }
-    }
-    return bookings;
-}
-
-// =============== BUSINESS LOGIC ===============
-int getNextEventID(const vector<Event>& eventlist) {
-    if (eventlist.empty()) return 1;
-    int maxID = 0;
-    for (const auto& event : eventlist) {
-        if (event.eventID > maxID) maxID = event.eventID;
-    }
-    return maxID + 1;
-}
-
-int getnextUserID(const vector<User>& Userlist) {
-    if (Userlist.empty()) return 1;
-    int maxID = 0;
-    for (const auto& user : Userlist) {
-        if (user.UserId > maxID) maxID = user.UserId;
-    }
-    return maxID + 1;
-}
-
-bool adminlogin() {
-    const string ADMIN_UserN = "admin";
-    const string ADMIN_Pass = "admin123";
-
-    showScreenHeader("ADMIN LOGIN");
-    string username = getlineinput("Username: ");
-    
-    // Password input
-    cout << "Password: ";
-    #ifdef _WIN32
-    HANDLE hStdin = GetStdHandle(STD_INPUT_HANDLE);
-    DWORD mode;
-    GetConsoleMode(hStdin, &mode);
-    SetConsoleMode(hStdin, mode & (~ENABLE_ECHO_INPUT));
-    #else
-    termios oldt;
-    tcgetattr(STDIN_FILENO, &oldt);
-    termios newt = oldt;
-    newt.c_lflag &= ~ECHO;
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    #endif
-
-    string password;
-    getline(cin, password);
-    
-    #ifdef _WIN32
-    SetConsoleMode(hStdin, mode);
-    #else
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    #endif
-
-    cout << endl;
-    
-    if (username != ADMIN_UserN || password != ADMIN_Pass) {
-        cout << "Access denied! Invalid credentials. Press Enter to return...";
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        return false;
-    }
-    return true;
-}
-void displayAllEvents(const vector<Event>& eventlist) {
-    showScreenHeader("ALL EVENTS");
-    
-    if (eventlist.empty()) {
-        cout << "No events registered yet.\n";
-        return;
-    }
-
-    cout << "\n" << string(102, '=') << "\n";
-    cout << left << setw(6) << "ID" 
-         << setw(30) << "EVENT NAME" 
-         << setw(26) << "LOCATION" 
-         << setw(17) << "DATE" 
-         << setw(22) << "TOTAL TICKETS AVAILABLE"
-         << "\n" << string(102, '=') << "\n";
-
-    for (const auto& event : eventlist) {
-        // Basic event info
-        cout << left << setw(6) << event.eventID 
-             << setw(30) << (event.eventName.length() > 24 ? event.eventName.substr(0, 21) + "..." : event.eventName)
-             << setw(26) << (event.eventLocation.length() > 19 ? event.eventLocation.substr(0, 16) + "..." : event.eventLocation)
-             << setw(17) << event.eventDate
-             << setw(22) << event.getTotalTickets();
-
-        // Ticket tiers (display first 2 tiers with ellipsis if more)
-        int tierCount = 0;
-        for (const auto& tier : event.ticketTiers) {
-            if (tierCount < 2) {
-                cout << "\n     - " << left << setw(12) << tier.first 
-                     << "$" << fixed << setprecision(2) << tier.second.first
-                     << " (" << tier.second.second << ")";
-            }
-            tierCount++;
-        }
-        if (tierCount > 2) {
-            cout << "\n     + " << (tierCount - 2) << " more tiers...";
-        }
-
-        cout << "\n" << string(102, '-') << "\n";
-    }
-}
-void displayAllUsers(const vector<User>& userList) {
-    showScreenHeader("ALL USERS");
-    
-    if (userList.empty()) {
-        cout << "No users registered.\n";
-        return;
-    }
-
-    // Table header
-    cout << "\n" << string(21, '=') << "\n";
-    cout << left << setw(10) << "USER ID" 
-         << setw(30) << "USER NAME" 
-         << "\n" << string(21, '=') << "\n";
-
-    // Table rows
-    for (const auto& user : userList) {
-        cout << left << setw(10) << user.UserId 
-             << setw(30) << user.UserName 
-             << "\n" << string(21, '-') << "\n";
-    }
-
-    // Footer with count
-    cout << "\nTotal Users: " << userList.size() << "\n";
-}
-void viewAllBookingsAdmin(const vector<Booking>& bookings, const vector<User>& Userlist, const vector<Event>& eventlist) {
-    showScreenHeader("ALL BOOKINGS - ADMIN VIEW");
-    
-    if (bookings.empty()) {
-        cout << "No bookings found.\n";
-        cout << "\nPress Enter to return...";
-        waitForEnter();
-        return;
-    }
-
-    // Group bookings by user ID
-    map<int, vector<const Booking*>> userBookings;
-    for (const auto& booking : bookings) {
-        userBookings[booking.userId].push_back(&booking);
-    }
-
-    // Display grouped bookings
-    for (const auto& [userId, bookingsList] : userBookings) {
-        // Find user details
-        string userName = "Unknown";
-        for (const auto& user : Userlist) {
-            if (user.UserId == userId) {
-                userName = user.UserName;
-                break;
-            }
-        }
-
-        cout << "\n===== USER: " << userName << " (ID: " << userId << ") =====\n";
-        cout << "-------------------------------------------------------------\n";
-        cout << left << setw(12) << "Booking ID" 
-             << setw(12) << "Event ID" 
-             << setw(20) << "Event Name" 
-             << setw(12) << "Date" 
-             << setw(15) << "Ticket Tier" 
-             << setw(8) << "Tickets" 
-             << setw(12) << "Total Price" 
-             << setw(12) << "Status" 
-             << endl;
-        cout << "-------------------------------------------------------------\n";
-
-        float userTotal = 0;
-        int userTickets = 0;
-
-        for (const auto& booking : bookingsList) {
-            // Find event details
-            string eventName = "Unknown";
-            string eventDate = "Unknown";
-            for (const auto& event : eventlist) {
-                if (event.eventID == booking->eventId) {
-                    eventName = event.eventName;
-                    eventDate = event.eventDate;
-                    break;
-                }
-            }
-
-            cout << left << setw(12) << booking->bookingId 
-                 << setw(12) << booking->eventId 
-                 << setw(20) << eventName 
-                 << setw(12) << eventDate 
-                 << setw(15) << booking->ticketTier 
-                 << setw(8) << booking->tickets 
-                 << "$" << fixed << setprecision(2) << setw(11) << booking->totalPrice 
-                 << setw(12) << booking->status 
-                 << endl;
-
-            if (booking->status == "Confirmed") {
-                userTotal += booking->totalPrice;
-                userTickets += booking->tickets;
-            }
-        }
-
-        cout << "-------------------------------------------------------------\n";
-        cout << "USER TOTALS: " << userTickets << " tickets | $" 
-             << fixed << setprecision(2) << userTotal << "\n";
-    }
-
-    // Add system-wide totals
-    float systemTotal = 0;
-    int systemTickets = 0;
-    int confirmedBookings = 0;
-    int cancelledBookings = 0;
-    
-    for (const auto& booking : bookings) {
-        if (booking.status == "Confirmed") {
-            systemTotal += booking.totalPrice;
-            systemTickets += booking.tickets;
-            confirmedBookings++;
-        } else {
-            cancelledBookings++;
-        }
-    }
-
-    cout << "\n===== SYSTEM TOTALS =====\n";
-    cout << "TOTAL BOOKINGS: " << bookings.size() << " (Confirmed: " << confirmedBookings 
-         << ", Cancelled: " << cancelledBookings << ")\n";
-    cout << "TOTAL CONFIRMED TICKETS: " << systemTickets << "\n";
-    cout << "TOTAL REVENUE: $" << fixed << setprecision(2) << systemTotal << "\n";
-
-}
-
-void adminPanel(vector<Event>& eventlist, vector<User> Userlist, vector<Booking>& bookings, int& nextBookingId) {
-    int choice;
-    do {
-        showScreenHeader("ADMIN PANEL");
-        cout << "1. Register New Event\n"
-             << "2. View All Events\n"
-             << "3. View All Users\n"
-             << "4. View All Bookings\n"
-             << "5. Return to Main Menu\n";
-        
-        choice = getMenuChoice("Enter your choice: ", 1, 5);
-
-        switch(choice) {
-            case 1: {
-                showScreenHeader("REGISTER NEW EVENT");
-                int id = getNextEventID(eventlist);
-                cout << "Event ID: " << id << endl;
-
-                string name = getlineinput("Enter Event Name: ");
-                string location = getlineinput("Enter Event Location: ");
-
-                string date;
-                bool validDate = false;
-                do {
-                    date = getlineinput("Enter Event Date (DD-MM-YYYY): ");
-                } while (!validdate(date));
-
-                Event newEvent(id, name, location, date);
-                
-                while (true) {
-                    cout << "\nAdd Ticket Catagory (or 'done' to finish):\n";
-                    string tierName = getlineinput("Enter Catagory Name: ");
-                    if (tierName == "done") break;
-
-                    float price;
-                    cout << "Enter price for this catagory: $";
-                    while (!(cin >> price)) {
-                        cin.clear();
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        cout << "Invalid input. Please enter a number: ";
-                    }
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-
-                    int quantity;
-                    cout << "Enter available quantity of tickets: ";
-                    while (!(cin >> quantity)) {
-                        cin.clear();
-                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                        cout << "Invalid input. Please enter a number: ";
-                    }
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-
-                    newEvent.addTicketTier(tierName, price, quantity);
-                }
-
-                if (newEvent.ticketTiers.empty()) {
-                    cout << "\nAdding default ticket catagory...\n";
-                    float price;
-                    cout << "Enter default ticket price: $";
-                    cin >> price;
-                    clearInput();
-
-                    int quantity;
-                    cout << "Enter available quantity: ";
-                    cin >> quantity;
-                    clearInput();
-
-                    newEvent.addTicketTier("Standard", price, quantity);
-                }
-
-                eventlist.push_back(newEvent);
-                saveEvents(eventlist);
-                cout << "\nEvent registered successfully!\n";
-                cout << "\nPress Enter to return...";
-                cin.get();  // Wait for exactly one Enter press
-                break;
-            }
-            case 2: {
-                showScreenHeader("ALL EVENTS");
-                if (eventlist.empty()) {
-                    cout << "No events registered yet.\n";
-                } else {
-                    
-                        displayAllEvents(eventlist);
-                    
-                }
-                cout << "\nPress Enter to return...";
-                cin.get();  // Wait for exactly one Enter press
-                break;
-            }
-            case 3: {
-                showScreenHeader("ALL USERS");
-                if (Userlist.empty()) {
-                    cout << "No users registered.\n";
-                } else {
-                    displayAllUsers(Userlist);
-                }
-                cout << "\nPress Enter to return...";
-                cin.get();  // Wait for exactly one Enter press
-                break;
-            }
-            case 4: {
-                viewAllBookingsAdmin(bookings, Userlist, eventlist);
-                cout << "\nPress Enter to return...";
-                cin.get();  // Wait for exactly one Enter press
-                break;
-            }
-            case 5:
-                return;
-        }
-    } while (true);
-}
-
-void userBookTicket(vector<Event>& eventlist, vector<User>& Userlist, vector<Booking>& bookings, int& nextBookingId) {
-    showScreenHeader("BOOK TICKETS");
-    
-    if (eventlist.empty()) {
-        cout << "No events available for booking.\n";
-        waitForEnter();
-        return;
-    }
-    if (Userlist.empty()) {
-        cout << "No users registered. Please register first.\n";
-        waitForEnter();
-        return;
-    }
-
-    int UserId;
-    cout << "Enter User ID: ";
-    cin >> UserId;
-    clearInput();
-
-    bool userFound = false;
-    for (const auto& user : Userlist) {
-        if (user.UserId == UserId) {
-            userFound = true;
-            break;
-        }
-    }
-
-    if (!userFound) {
-        cout << "User ID not found.\n";
-        waitForEnter();
-        return;
-    }
-
-    cout << "\n===== Available Events =====\n";
-    for (const auto& event : eventlist) {
-        if (event.getTotalTickets() > 0) {
-            cout << "ID: " << event.eventID << " | " << event.eventName 
-                 << " (" << event.eventDate << " at " << event.eventLocation << ")\n";
-        }
-    }
-
-    int eventID;
-    cout << "\nEnter Event ID to book: ";
-    cin >> eventID;
-    clearInput();
-
-    Event* eventPtr = nullptr;
-    for (auto& event : eventlist) {
-        if (event.eventID == eventID) {
-            eventPtr = &event;
-            break;
-        }
-    }
-
-    if (!eventPtr) {
-        cout << "Event ID not found.\n";
-        waitForEnter();
-        return;
-    }
-
-    if (eventPtr->getTotalTickets() <= 0) {
-        cout << "This event is sold out.\n";
-        waitForEnter();
-        return;
-    }
-
-    cout << "\n===== Available Ticket Tiers =====\n";
-    cout << "0. Go back\n";
-    vector<pair<string, pair<float, int>>> availableTiers;
-    int index = 1;
-    
-    for (const auto& tier : eventPtr->ticketTiers) {
-        if (tier.second.second > 0) {
-            cout << index << ". " << tier.first << " - $" << fixed << setprecision(2)
-                 << tier.second.first << " (" << tier.second.second << " available)\n";
-            availableTiers.push_back(tier);
-            index++;
-        }
-    }
-
-    if (availableTiers.empty()) {
-        cout << "No ticket tiers available.\n";
-        waitForEnter();
-        return;
-    }
-
-    int tierChoice = getMenuChoice(
-        "\nSelect ticket tier (0-" + to_string(availableTiers.size()) + "): ", 
-        0, 
-        availableTiers.size()
-    );
-    
-    if (tierChoice == 0) {
-        cout << "Returning to menu.\n";
-        waitForEnter();
-        return;
-    }
-
-    const auto& selectedTier = availableTiers[tierChoice-1];
-    string tierName = selectedTier.first;
-    float tierPrice = selectedTier.second.first;
-    int tierAvailable = selectedTier.second.second;
-
-    int ticketQuantity;
-    while (true) {
-        cout << "Number of tickets to book: ";
-        cin >> ticketQuantity;
-        clearInput();
-        
-        if (ticketQuantity <= 0) {
-            cout << "Please enter at least 1 ticket.\n";
-        } else if (ticketQuantity > tierAvailable) {
-            cout << "Only " << tierAvailable << " tickets available.\n";
-        } else {
-            break;
-        }
-    }
-
-    float totalPrice = ticketQuantity * tierPrice;
-
-    cout << "\n===== Booking Summary =====\n";
-    cout << "Event: " << eventPtr->eventName << endl;
-    cout << "Date: " << eventPtr->eventDate << endl;
-    cout << "Location: " << eventPtr->eventLocation << endl;
-    cout << "Ticket Tier: " << tierName << endl;
-    cout << "Quantity: " << ticketQuantity << endl;
-    cout << "Price per Ticket: $" << fixed << setprecision(2) << tierPrice << endl;
-    cout << "Total Price: $" << fixed << setprecision(2) << totalPrice << endl;
-
-    char confirm;
-    do {
-        cout << "\nConfirm booking? (Y/N): ";
-        cin >> confirm;
-        confirm = toupper(confirm);
-        
-    } while (confirm != 'Y' && confirm != 'N');
-
-    if (confirm == 'Y') {
-        eventPtr->ticketTiers[tierName].second -= ticketQuantity;
-        bookings.emplace_back(nextBookingId++, UserId, eventID, ticketQuantity, totalPrice, tierName);
-        saveEvents(eventlist);
-        saveBookings(bookings);
-        
-        cout << "\nBooking confirmed!\n";
-        cout << "Booking ID: " << nextBookingId-1 << endl;
-    } else {
-        cout << "Booking cancelled.\n";
-    }
-    cout << "\nPress Enter to return...";
-    waitForEnter();
-}
-
-void cancelBooking(vector<Event>& eventlist, vector<Booking>& bookings) {
-    showScreenHeader("CANCEL BOOKING");
-    
-    if (bookings.empty()) {
-        cout << "No bookings to cancel.\n";
-        waitForEnter();
-        return;
-    }
-
-    int bookingId;
-    cout << "Enter Booking ID to cancel: ";
-    cin >> bookingId;
-
-    bool found = false;
-    for (auto& booking : bookings) {
-        if (booking.bookingId == bookingId && booking.status == "Confirmed") {
-            for (auto& event : eventlist) {
-                if (event.eventID == booking.eventId) {
-                    event.ticketTiers[booking.ticketTier].second += booking.tickets;
-                    break;
-                }
-            }
-            booking.status = "Cancelled";
-            found = true;
-            
-            cout << "\n===== Cancellation Summary =====\n";
-            cout << "Booking ID: " << booking.bookingId << " cancelled\n";
-            cout << booking.tickets << " tickets released\n";
-            
-            saveEvents(eventlist);
-            saveBookings(bookings);
-            break;
-        }
-    }
-
-    if (!found) {
-        cout << "Booking not found or already cancelled.\n";
-    }
-    cout << "\nPress Enter to return...";
-    waitForEnter();
-}
-
-void viewUserBookings(const vector<Booking>& bookings, const vector<User>& Userlist, const vector<Event>& eventlist) {
-    showScreenHeader("MY BOOKINGS");
-    
-    if (bookings.empty()) {
-        cout << "No bookings found.\n";
-        cout << "\nPress Enter to return...";
-        waitForEnter();
-        return;
-    }
-
-    int userId;
-    cout << "Enter your User ID: ";
-    cin >> userId;
-
-    // Find user
-    string userName = "No user found with this id";
-    for (const auto& user : Userlist) {
-        if (user.UserId == userId) {
-            userName = user.UserName;
-            break;
-        }
-    }
-
-    cout << "\nUser: " << userName << " (ID: " << userId << ")\n\n";
-    
-    // Table header
-    cout << left << setw(12) << "Booking ID" 
-         << setw(15) << "Status" 
-         << setw(15) << "Event" 
-         << setw(12) << "Date" 
-         << setw(15) << "Location" 
-         << setw(12) << "Tier" 
-         << setw(8) << "Tickets" 
-         << setw(12) << "Total Price" 
-         << endl;
-
-    cout << string(95, '-') << endl;
-
-    bool hasBookings = false;
-    for (const auto& booking : bookings) {
-        if (booking.userId == userId) {
-            hasBookings = true;
-            
-            // Find event details
-            string eventName = "Unknown";
-            string eventDate = "Unknown";
-            string eventLocation = "Unknown";
-            
-            for (const auto& event : eventlist) {
-                if (event.eventID == booking.eventId) {
-                    eventName = event.eventName;
-                    eventDate = event.eventDate;
-                    eventLocation = event.eventLocation;
-                    break;
-                }
-            }
-
-            cout << left << setw(12) << booking.bookingId 
-                 << setw(15) << booking.status 
-                 << setw(15) << eventName 
-                 << setw(12) << eventDate 
-                 << setw(15) << eventLocation 
-                 << setw(12) << booking.ticketTier 
-                 << setw(8) << booking.tickets 
-                 << "$" << fixed << setprecision(2) << setw(11) << booking.totalPrice 
-                 << endl;
-        }
-    }
-
-    if (!hasBookings) {
-        cout << "No bookings found for User ID: " << userId << endl;
-    }
-    cout << "\nPress Enter to return...";
-    waitForEnter();
-}
-
-int main() {
-    initializeDataFiles();
-    vector<Event> eventlist = loadEvents();
-    vector<User> Userlist = loadUsers();
-    vector<Booking> bookings = loadBookings();
-
-    int nextBookingId = 1;
-    if (!bookings.empty()) {
-        nextBookingId = bookings.back().bookingId + 1;
-    }
-
-    int choice;
-    do {
-        showScreenHeader("EVENT TICKETING SYSTEM");
-        cout << "1. Register User\n"
-             << "2. View All Events\n"
-             << "3. Book Tickets\n"
-             << "4. Cancel Booking\n"
-             << "5. View My Bookings\n"
-             << "6. Admin Login\n"
-             << "7. Exit\n";
-        
-        choice = getMenuChoice("Enter your choice: ", 1, 7);
-
-        switch(choice) {
-            case 1: {
-                showScreenHeader("USER REGISTRATION");
-                int UserId = getnextUserID(Userlist);
-                cout << "Your User ID: " << UserId <<endl ;
-
-                string UserName = getlineinput("Enter User Name: ");
-                User newUser(UserId, UserName);
-                Userlist.push_back(newUser);
-                saveUsers(Userlist);
-                
-                cout << "\nUser registered successfully!\n";
-                cout << "\nPress Enter to return...";
-                cin.get();
-                break;
-            }
-            case 2:
-                showScreenHeader("AVAILABLE EVENTS");
-                if (eventlist.empty()) {
-                    cout << "No events available.\n";
-                } else {
-                    displayAllEvents(eventlist);  // Show compact event list
-                }
-                cout << "\nPress Enter to return...";
-                cin.get();  // Wait for exactly one Enter press
-                break;
-            case 3:
-                userBookTicket(eventlist, Userlist, bookings, nextBookingId);
-                break;
-            case 4:
-                cancelBooking(eventlist, bookings);
-                break;
-            case 5:
-                viewUserBookings(bookings, Userlist, eventlist);
-                break;
-            case 6:
-                if (!adminlogin()) {
-                    break;  // Just break if login fails (adminlogin() handles the prompt)
-                }
-                adminPanel(eventlist, Userlist, bookings, nextBookingId);
-                break;
-            case 7:
-                saveUsers(Userlist);
-                saveEvents(eventlist);
-                saveBookings(bookings);
-                cout << "\nExiting program. Goodbye!\n";
-                break;
-            default:
-                cout << "Invalid choice! Please try again.\n";
-                waitForEnter();
-        }
-    } while (choice != 7);
-
-    return 0;
+#include <iostream>
+#include <vector>
+#include <cctype>
+#include <iomanip>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <iterator>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <cstdio>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <type_traits>
+#include <deque>
+#include <condition_variable>
+#include <csignal>
+#include <cerrno>
+#include <optional>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <conio.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/statvfs.h>
+#endif
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#define BOOKING_SERVER
+#define BOOKING_SHARED
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define BOOKING_SCAN_AVX2
+#endif
+using namespace std;
+
+// =============== TERMINAL ===============
+// Screens are drawn with ANSI escape sequences rather than by running
+// clear/cls. A screen that is redrawn in place (the pages of a long list) is
+// built off screen as a list of lines, and only the lines that differ from
+// what is already shown are rewritten, all in one write.
+
+// Set when running without a user at the terminal (benchmarks)
+bool quietScreens = false;
+
+class Terminal {
+public:
+    // Rows and columns of the window; 24x80 when there is no terminal
+    static void size(int& rows, int& columns) {
+        rows = 24;
+        columns = 80;
+        #ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+            rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+            columns = info.srWindow.Right - info.srWindow.Left + 1;
+        }
+        #else
+        winsize window;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) == 0 && window.ws_row > 0 && window.ws_col > 0) {
+            rows = window.ws_row;
+            columns = window.ws_col;
+        }
+        #endif
+    }
+
+    // Screen rows a line takes up once the terminal has wrapped it
+    static int rowsFor(string_view line, int columns) {
+        return line.empty() ? 1 : (int)((line.size() + columns - 1) / columns);
+    }
+
+    static void clear() {
+        if (!escapesWork()) {
+            #ifdef _WIN32
+            system("cls");
+            #endif
+        } else {
+            cout << "\x1b[H\x1b[2J";
+        }
+        forget();
+    }
+
+    // Shows lines from the top of the screen and leaves the cursor at the
+    // end of the last one. If the previous frame is still on screen, only
+    // the lines that changed are rewritten. lines must fit in the window.
+    static void present(const vector<string>& lines) {
+        int rows, columns;
+        size(rows, columns);
+        int needed = 0;
+        for (const auto& line : lines) needed += rowsFor(line, columns);
+        if (!escapesWork() || needed > rows) {
+            clear();
+            for (size_t i = 0; i < lines.size(); i++) cout << (i ? "\n" : "") << lines[i];
+            cout << flush;
+            return;
+        }
+
+        string out;
+        bool redraw = !onScreen || rows != shownRows || columns != shownColumns;
+        if (redraw) {
+            out += "\x1b[H\x1b[2J";
+            shown.clear();
+        }
+        // A line is left alone only if it is unchanged and starts on the same row
+        int row = 1, oldRow = 1;
+        for (size_t i = 0; i < lines.size(); i++) {
+            bool same = i < shown.size() && oldRow == row && shown[i] == lines[i];
+            if (!same) {
+                moveTo(out, row, 1);
+                out += lines[i];
+                // A line that fills its last row exactly leaves nothing to clear
+                if (lines[i].size() % columns != 0 || lines[i].empty()) out += "\x1b[K";
+            }
+            if (i < shown.size()) oldRow += rowsFor(shown[i], columns);
+            row += rowsFor(lines[i], columns);
+        }
+        for (size_t i = lines.size(); i < shown.size(); i++) oldRow += rowsFor(shown[i], columns);
+        if (oldRow > row) {
+            moveTo(out, row, 1);
+            out += "\x1b[J";
+        }
+        if (!lines.empty()) {
+            const string& last = lines.back();
+            int lastRow = row - rowsFor(last, columns);
+            int offset = last.empty() ? 0 : (int)(last.size() - 1) % columns + 1;
+            moveTo(out, lastRow + (last.empty() ? 0 : (int)(last.size() - 1) / columns), min(offset + 1, columns));
+        }
+
+        cout.write(out.data(), out.size());
+        cout.flush();
+        shown = lines;
+        shownRows = rows;
+        shownColumns = columns;
+        onScreen = true;
+    }
+
+    // Anything else written to the screen (or typed) may have moved the
+    // last frame, so the next one is drawn in full
+    static void forget() {
+        onScreen = false;
+    }
+
+    // One key press, without waiting for Enter at a terminal. Enter reads
+    // as '\n'; EOF at the end of input.
+    static int readKey() {
+        cout.flush();
+        if (cin.rdbuf()->in_avail() > 0) return cin.get();  // typed ahead
+        #ifdef _WIN32
+        if (_isatty(_fileno(stdin))) {
+            int key = _getch();
+            return key == '\r' ? '\n' : key;
+        }
+        #else
+        if (isatty(STDIN_FILENO)) {
+            termios oldt;
+            tcgetattr(STDIN_FILENO, &oldt);
+            termios raw = oldt;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+            unsigned char key;
+            ssize_t got = ::read(STDIN_FILENO, &key, 1);
+            tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+            return got == 1 ? key : EOF;
+        }
+        #endif
+        string line;
+        if (!getline(cin, line)) return EOF;
+        return line.empty() ? '\n' : line[0];
+    }
+
+private:
+    inline static vector<string> shown;
+    inline static int shownRows = 0;
+    inline static int shownColumns = 0;
+    inline static bool onScreen = false;
+
+    static void moveTo(string& out, int row, int column) {
+        out += "\x1b[";
+        out += to_string(row);
+        out += ';';
+        out += to_string(column);
+        out += 'H';
+    }
+
+    // Windows consoles only take escape sequences once asked to
+    static bool escapesWork() {
+        #ifdef _WIN32
+        static bool enabled = [] {
+            HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+            DWORD mode;
+            #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+            const DWORD ENABLE_VIRTUAL_TERMINAL_PROCESSING = 0x0004;
+            #endif
+            return GetConsoleMode(console, &mode) &&
+                   SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }();
+        return enabled;
+        #else
+        return true;
+        #endif
+    }
+};
+
+// Shows a long list a screenful at a time. The title and heading lines are
+// repeated at the top of every page. Each block (one or more lines) is kept
+// on one page unless it is longer than a page. Enter or N moves on, P goes
+// back and Q returns; Enter on the last page returns too. In quiet mode
+// everything is written out at once without waiting.
+class Pager {
+public:
+    Pager(const string& title) {
+        top.push_back("");
+        top.push_back("===== " + title + " =====");
+    }
+
+    void heading(const string& text) {
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == string::npos) end = text.size();
+            top.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
+    // text may hold several lines
+    void add(string_view text) {
+        blockStarts.push_back(lineStarts.size());
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == string_view::npos) end = text.size();
+            lineStarts.push_back(body.size());
+            body.append(text.substr(start, end - start));
+            body += '\n';
+            start = end + 1;
+        }
+    }
+
+    void show() {
+        if (quietScreens) {
+            for (const auto& line : top) cout << line << '\n';
+            cout.write(body.data(), body.size());
+            return;
+        }
+
+        size_t first = 0;  // first body line of the page shown
+        while (true) {
+            vector<size_t> pages = pageStarts();
+            size_t page = upper_bound(pages.begin(), pages.end(), first) - pages.begin() - 1;
+            first = pages[page];
+            size_t end = page + 1 < pages.size() ? pages[page + 1] : lineStarts.size();
+            bool last = page + 1 == pages.size();
+
+            vector<string> frame = top;
+            for (size_t i = first; i < end; i++) frame.emplace_back(line(i));
+            frame.push_back("");
+            if (pages.size() == 1) {
+                frame.push_back("Press Enter to return...");
+            } else {
+                frame.push_back("Page " + to_string(page + 1) + " of " + to_string(pages.size()) +
+                                (last ? " - Enter: return" : " - Enter: next page") + ", P: previous, Q: return ");
+            }
+            Terminal::present(frame);
+
+            int key = tolower(Terminal::readKey());
+            if (key == EOF || key == 'q') break;
+            if (key == 'p') {
+                if (page > 0) first = pages[page - 1];
+            } else if (key == '\n' || key == 'n' || key == ' ') {
+                if (last) break;
+                first = pages[page + 1];
+            }
+        }
+        cout << '\n';
+        Terminal::forget();
+    }
+
+private:
+    vector<string> top;
+    string body;                 // every line, each ended by '\n'
+    vector<size_t> lineStarts;   // where each line starts in body
+    vector<size_t> blockStarts;  // first line of each block
+
+    string_view line(size_t i) const {
+        size_t end = i + 1 < lineStarts.size() ? lineStarts[i + 1] : body.size();
+        return string_view(body).substr(lineStarts[i], end - 1 - lineStarts[i]);
+    }
+
+    // First line of each page for the current window size
+    vector<size_t> pageStarts() const {
+        int rows, columns;
+        Terminal::size(rows, columns);
+        int room = rows - 2;  // blank line and prompt
+        for (const auto& text : top) room -= Terminal::rowsFor(text, columns);
+        room = max(room, 1);
+
+        vector<size_t> pages{0};
+        int used = 0;
+        size_t block = 0;
+        for (size_t i = 0; i < lineStarts.size(); i++) {
+            // A block that would not fit starts a new page, if it fits there
+            if (block < blockStarts.size() && blockStarts[block] == i) {
+                size_t blockEnd = block + 1 < blockStarts.size() ? blockStarts[block + 1] : lineStarts.size();
+                int blockRows = 0;
+                for (size_t j = i; j < blockEnd; j++) blockRows += Terminal::rowsFor(line(j), columns);
+                if (used > 0 && used + blockRows > room && blockRows <= room) {
+                    pages.push_back(i);
+                    used = 0;
+                }
+                block++;
+            }
+            int lineRows = Terminal::rowsFor(line(i), columns);
+            if (used > 0 && used + lineRows > room) {
+                pages.push_back(i);
+                used = 0;
+            }
+            used += lineRows;
+        }
+        return pages;
+    }
+};
+
+// =============== HELPER FUNCTIONS ===============
+void clearScreen() {
+    if (quietScreens) return;
+    Terminal::clear();
+}
+
+void waitForEnter() {
+    // Clear any existing input first
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    // Wait for exactly one Enter press
+    while (cin.get() != '\n') {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+}
+
+void makeDirectory(const string& path) {
+    #ifdef _WIN32
+    _mkdir(path.c_str());
+    #else
+    mkdir(path.c_str(), 0755);
+    #endif
+}
+
+// Forces a file, or the names in a directory, out to disk. False if it
+// could not be opened or synced.
+bool syncFile(const string& path) {
+    #ifdef _WIN32
+    if (filesystem::is_directory(path)) return true;  // no handle to sync a directory with
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    bool synced = _commit(fd) == 0;
+    _close(fd);
+    #else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    #endif
+    return synced;
+}
+
+bool changeDirectory(const string& path) {
+    #ifdef _WIN32
+    return _chdir(path.c_str()) == 0;
+    #else
+    return chdir(path.c_str()) == 0;
+    #endif
+}
+
+void clearInput() {
+    cin.clear();
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+void showScreenHeader(const string& title) {
+    clearScreen();
+    cout << "\n===== " << title << " =====" << endl;
+}
+
+string getlineinput(const string& prompt) {
+    string input;
+    cout << prompt;
+    getline(cin, input);
+    return input;
+}
+
+int getMenuChoice(const string& prompt, int minChoice, int maxChoice) {
+    string input;
+    while (true) {
+        cout << prompt;
+        getline(cin, input);
+        
+        // Skip empty input (just Enter pressed)
+        if (input.empty()) {
+            continue;
+        }
+        
+        // Check if input is numeric
+        bool isNumeric = true;
+        for (char c : input) {
+            if (!isdigit(c)) {
+                isNumeric = false;
+                break;
+            }
+        }
+        
+        if (!isNumeric) {
+            cout << "Invalid input! Please enter a number between " 
+                 << minChoice << " and " << maxChoice << ".\n";
+            continue;
+        }
+        
+        // Convert to integer
+        stringstream ss(input);
+        int choice;
+        ss >> choice;
+        
+        // Validate range
+        if (choice < minChoice || choice > maxChoice) {
+            cout << "Please enter a number between " 
+                 << minChoice << " and " << maxChoice << ".\n";
+            continue;
+        }
+        
+        return choice;
+    }
+}
+
+// =============== CORE FUNCTIONALITY ===============
+// Dates are stored as "DD-MM-YYYY" text and, for sorting and range queries,
+// as a day number (days since 01-01-1970).
+const int NO_DATE = numeric_limits<int>::min();
+
+struct CivilDate {
+    int day = 0;
+    int month = 0;
+    int year = 0;
+};
+
+enum DateCheck {
+    DATE_OK,
+    DATE_BAD_FORMAT,
+    DATE_NO_31ST,
+    DATE_BAD_FEBRUARY
+};
+
+constexpr bool isLeapYear(int year) {
+    return (year % 400 == 0) || (year % 100 != 0 && year % 4 == 0);
+}
+
+constexpr int digitValue(char c) {
+    return c >= '0' && c <= '9' ? c - '0' : -1;
+}
+
+// Accepts exactly DD-MM-YYYY with a day 01-31 and month 01-12, then checks
+// the day against the length of the month. The year is not range checked.
+constexpr DateCheck parseDate(string_view text, CivilDate& date) {
+    if (text.size() != 10 || text[2] != '-' || text[5] != '-') return DATE_BAD_FORMAT;
+    int digits[8] = {};
+    const int positions[8] = {0, 1, 3, 4, 6, 7, 8, 9};
+    for (int i = 0; i < 8; i++) {
+        digits[i] = digitValue(text[positions[i]]);
+        if (digits[i] < 0) return DATE_BAD_FORMAT;
+    }
+    date.day = digits[0] * 10 + digits[1];
+    date.month = digits[2] * 10 + digits[3];
+    date.year = digits[4] * 1000 + digits[5] * 100 + digits[6] * 10 + digits[7];
+    if (date.day < 1 || date.day > 31 || date.month < 1 || date.month > 12) return DATE_BAD_FORMAT;
+
+    if ((date.month == 4 || date.month == 6 || date.month == 9 || date.month == 11) && date.day > 30) {
+        return DATE_NO_31ST;
+    }
+    if (date.month == 2 && date.day > (isLeapYear(date.year) ? 29 : 28)) {
+        return DATE_BAD_FEBRUARY;
+    }
+    return DATE_OK;
+}
+
+// Days since 01-01-1970 in the proleptic Gregorian calendar
+constexpr int dayNumber(const CivilDate& date) {
+    int y = date.year - (date.month <= 2 ? 1 : 0);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (date.month > 2 ? date.month - 3 : date.month + 9) + 2) / 5 + date.day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Day number of a DD-MM-YYYY string, or NO_DATE if it is not a valid date
+constexpr int dateToDayNumber(string_view text) {
+    CivilDate date;
+    return parseDate(text, date) == DATE_OK ? dayNumber(date) : NO_DATE;
+}
+
+static_assert(dateToDayNumber("01-01-1970") == 0, "epoch");
+static_assert(dateToDayNumber("29-02-2028") - dateToDayNumber("28-02-2028") == 1, "leap day");
+static_assert(dateToDayNumber("01-03-2025") - dateToDayNumber("28-02-2025") == 1, "no leap day");
+static_assert(dateToDayNumber("29-02-2100") == NO_DATE, "2100 is not a leap year");
+static_assert(dateToDayNumber("31-04-2025") == NO_DATE, "April has 30 days");
+static_assert(dateToDayNumber("1-06-2025") == NO_DATE, "two-digit day");
+static_assert(dateToDayNumber("15-13-2025") == NO_DATE, "month range");
+
+int todayDayNumber() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    CivilDate today;
+    today.day = local.tm_mday;
+    today.month = local.tm_mon + 1;
+    today.year = local.tm_year + 1900;
+    return dayNumber(today);
+}
+
+bool validdate(const string& date) {
+    CivilDate parts;
+    DateCheck check = parseDate(date, parts);
+
+    if (check == DATE_BAD_FORMAT) {
+        cout << "Error: Date must be in DD-MM-YYYY format (e.g., 15-06-2025).\n";
+        return false;
+    }
+
+    // Check year (must be 2025 or later)
+    if (parts.year < 2025) {
+        cout << "Invalid year! Events can only be created for 2025 or later.\n";
+        return false;
+    }
+
+    if (check == DATE_NO_31ST) {
+        cout << "Invalid day! This month only has 30 days.\n";
+        return false;
+    }
+
+    if (check == DATE_BAD_FEBRUARY) {
+        bool isLeap = isLeapYear(parts.year);
+        cout << "Invalid day! February only has " << (isLeap ? 29 : 28) << " days in " << parts.year << ".\n";
+        return false;
+    }
+
+    return true;
+}
+
+// The same rules without the messages, for rows that do not come from a
+// prompt. Returns what is wrong with the date, or nullptr if it is valid.
+const char* dateProblem(string_view date) {
+    CivilDate parts;
+    DateCheck check = parseDate(date, parts);
+    if (check == DATE_BAD_FORMAT) return "BAD_DATE_FORMAT";
+    if (parts.year < 2025) return "DATE_BEFORE_2025";
+    if (check == DATE_NO_31ST) return "NO_31ST_IN_MONTH";
+    if (check == DATE_BAD_FEBRUARY) return "BAD_FEBRUARY_DATE";
+    return nullptr;
+}
+
+// Each event interns its own tier names. The event's tiers, bookings and
+// waitlist entries refer to a tier by its small TierId in that event's
+// table, so comparing tiers is an integer compare and bookings do not each
+// carry a copy of the name. A table holds the names of its event's tiers in
+// the order they were added, then any other tier the event's bookings name,
+// and goes with the event: one event's names never use up another's ids.
+// Like the rest of an event, a table is only changed while nothing else is
+// reading the event (loading, or with the model held exclusively).
+typedef uint16_t TierId;
+
+class TierNames {
+public:
+    // Looks a name up, adding it if it is new. False once the event has used
+    // every TierId.
+    bool intern(string_view tierName, TierId& id) {
+        if (find(tierName, id)) return true;
+        if (names.size() > numeric_limits<TierId>::max()) return false;
+        id = (TierId)names.size();
+        names.emplace_back(tierName);
+        return true;
+    }
+
+    // Looks a name up without adding it. Events have a handful of tiers, so
+    // a scan beats hashing.
+    bool find(string_view tierName, TierId& id) const {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == tierName) {
+                id = (TierId)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const {
+        return names.size();
+    }
+
+    const string& name(TierId id) const {
+        static const string unknown = "Unknown";
+        return id < names.size() ? names[id] : unknown;
+    }
+
+private:
+    vector<string> names;
+};
+
+inline int lowestSetBit(uint64_t word) {
+    #if defined(__GNUC__)
+    return __builtin_ctzll(word);
+    #else
+    int bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+    #endif
+}
+
+#ifdef BOOKING_SHARED
+// A mutex that can live in shared memory and be locked from several
+// processes. It is robust: if a process dies while holding it, the next
+// process to lock it takes it over instead of waiting forever.
+class ProcessMutex {
+public:
+    void init() {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&handle, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+    }
+
+    void lock() {
+        if (pthread_mutex_lock(&handle) == EOWNERDEAD) {
+            pthread_mutex_consistent(&handle);
+        }
+    }
+
+    void unlock() {
+        pthread_mutex_unlock(&handle);
+    }
+
+private:
+    pthread_mutex_t handle;
+};
+#endif
+
+// Assigned seating for one tier. Each row is a bitset, one bit per seat
+// (1 = taken), 64 seats to a word; seat ids count row by row from 0. The
+// bits past the last seat of a row are kept set so a run of free seats never
+// crosses into the next row. Free runs are found a word at a time: all-taken
+// words are skipped and run edges are located with a count-trailing-zeros.
+// A map can be moved into the shared inventory segment, after which the
+// bits, free counts and lock are the ones every process uses.
+class SeatMap {
+public:
+    int rows;
+    int seatsPerRow;
+
+    SeatMap(int rowCount, int perRow)
+        : rows(rowCount), seatsPerRow(perRow), wordsPerRow((perRow + 63) / 64),
+          taken((size_t)rowCount * wordsPerRow, 0), rowFree(rowCount, perRow) {
+        int spare = wordsPerRow * 64 - perRow;
+        if (spare > 0) {
+            for (int row = 0; row < rows; row++) {
+                taken[(row + 1) * wordsPerRow - 1] |= ~0ull << (64 - spare);
+            }
+        }
+        takenBits = taken.data();
+        freeCounts = rowFree.data();
+    }
+
+    SeatMap(const SeatMap&) = delete;
+    SeatMap& operator=(const SeatMap&) = delete;
+
+    // Most seats one map can have, which also keeps every seat id and seat
+    // count in an int
+    static const int MAX_SEATS = 1 << 20;
+
+    // Whether a map can be built for a layout read from outside the program
+    static bool validLayout(int rowCount, int perRow) {
+        return rowCount > 0 && perRow > 0 && (long long)rowCount * perRow <= MAX_SEATS;
+    }
+
+    // Bytes of shared memory share() needs for this map
+    size_t sharedSize() const {
+        return sizeof(uint64_t) * taken.size() + sizeof(int) * rowFree.size();
+    }
+
+    #ifdef BOOKING_SHARED
+    // Switches to the seat state at block, guarded by blockLock. A fresh
+    // block gets this map's state copied in; otherwise the map adopts what
+    // other processes have already booked.
+    void share(char* block, ProcessMutex* blockLock, bool fresh) {
+        uint64_t* sharedBits = (uint64_t*)block;
+        int* sharedFree = (int*)(block + sizeof(uint64_t) * taken.size());
+        if (fresh) {
+            memcpy(sharedBits, taken.data(), sizeof(uint64_t) * taken.size());
+            memcpy(sharedFree, rowFree.data(), sizeof(int) * rowFree.size());
+        }
+        takenBits = sharedBits;
+        freeCounts = sharedFree;
+        sharedLock = blockLock;
+    }
+    #endif
+
+    // Best block of count adjacent seats: the front-most row that has one,
+    // as close to the middle of that row as it gets. Marks the block taken
+    // and returns its first seat id, or -1 if no row has room.
+    int reserveBest(int count) {
+        if (count <= 0 || count > seatsPerRow) return -1;
+        Guard guard(*this);
+        for (int row = 0; row < rows; row++) {
+            if (freeCounts[row] < count) continue;
+            int seat = bestInRow(row, count);
+            if (seat >= 0) {
+                setSeats(row, seat, count, true);
+                return row * seatsPerRow + seat;
+            }
+        }
+        return -1;
+    }
+
+    void release(int firstSeat, int count) {
+        Guard guard(*this);
+        if (inRange(firstSeat, count)) {
+            setSeats(firstSeat / seatsPerRow, firstSeat % seatsPerRow, count, false);
+        }
+    }
+
+    // Marks seats that are already booked (when loading). False if the block
+    // does not fit the map.
+    bool markTaken(int firstSeat, int count) {
+        Guard guard(*this);
+        if (!inRange(firstSeat, count)) return false;
+        setSeats(firstSeat / seatsPerRow, firstSeat % seatsPerRow, count, true);
+        return true;
+    }
+
+    // "Row 3, seats 5-8" (rows and seats numbered from 1)
+    string label(int firstSeat, int count) const {
+        int seat = firstSeat % seatsPerRow + 1;
+        string text = "Row " + to_string(firstSeat / seatsPerRow + 1) + ", seat";
+        if (count == 1) return text + " " + to_string(seat);
+        return text + "s " + to_string(seat) + "-" + to_string(seat + count - 1);
+    }
+
+private:
+    size_t wordsPerRow;
+    vector<uint64_t> taken;
+    vector<int> rowFree;
+    uint64_t* takenBits;  // taken, or its copy in shared memory
+    int* freeCounts;      // rowFree, likewise
+    mutex lock;
+    #ifdef BOOKING_SHARED
+    ProcessMutex* sharedLock = nullptr;
+    #endif
+
+    class Guard {
+    public:
+        Guard(SeatMap& seatMap) : map(seatMap) {
+            #ifdef BOOKING_SHARED
+            if (map.sharedLock) {
+                map.sharedLock->lock();
+                return;
+            }
+            #endif
+            map.lock.lock();
+        }
+
+        ~Guard() {
+            #ifdef BOOKING_SHARED
+            if (map.sharedLock) {
+                map.sharedLock->unlock();
+                return;
+            }
+            #endif
+            map.lock.unlock();
+        }
+
+    private:
+        SeatMap& map;
+    };
+
+    bool inRange(int firstSeat, int count) const {
+        return firstSeat >= 0 && count > 0 && firstSeat / seatsPerRow < rows &&
+               firstSeat % seatsPerRow + count <= seatsPerRow;
+    }
+
+    int bestInRow(int row, int count) const {
+        const uint64_t* words = &takenBits[row * wordsPerRow];
+        int idealStart = (seatsPerRow - count) / 2;
+        int best = -1;
+        int bestDistance = numeric_limits<int>::max();
+        auto consider = [&](int start, int end) {
+            if (end - start < count) return;
+            int seat = min(max(idealStart, start), end - count);
+            if (abs(seat - idealStart) < bestDistance) {
+                bestDistance = abs(seat - idealStart);
+                best = seat;
+            }
+        };
+
+        int runStart = -1;
+        for (size_t w = 0; w < wordsPerRow; w++) {
+            uint64_t takenBits = words[w];
+            int base = w * 64;
+            int bit = 0;
+            while (bit < 64) {
+                if (runStart < 0) {
+                    uint64_t freeAhead = ~takenBits >> bit;
+                    if (!freeAhead) break;
+                    bit += lowestSetBit(freeAhead);
+                    runStart = base + bit;
+                }
+                uint64_t takenAhead = takenBits >> bit;
+                if (!takenAhead) break;  // the run carries on into the next word
+                bit += lowestSetBit(takenAhead);
+                consider(runStart, base + bit);
+                runStart = -1;
+            }
+        }
+        if (runStart >= 0) consider(runStart, seatsPerRow);
+        return best;
+    }
+
+    void setSeats(int row, int seat, int count, bool isTaken) {
+        uint64_t* words = &takenBits[row * wordsPerRow];
+        for (int s = seat; s < seat + count; s++) {
+            uint64_t bit = 1ull << (s % 64);
+            if (isTaken) {
+                words[s / 64] |= bit;
+            } else {
+                words[s / 64] &= ~bit;
+            }
+        }
+        freeCounts[row] += isTaken ? -count : count;
+    }
+};
+
+// A tier's counts when they are kept in the shared inventory segment, so
+// that several processes sell from the same numbers (see SHARED INVENTORY)
+class SharedCounts {
+public:
+    atomic<int> remaining;
+    atomic<int> held;
+};
+
+// Remaining count is atomic so concurrent buyers can reserve from the same
+// tier without taking a lock (see BookingEngine). Tickets in a timed hold
+// are out of remaining but still counted in held, so they are saved as
+// unsold (holds do not survive a restart). Tiers with assigned seating also
+// have a seat map, shared by copies of the tier, and the counts can be
+// moved to shared memory, which copies of the tier then also use. Every
+// change to remaining is also applied to the owning TierList's cached total.
+class TicketTier {
+public:
+    TierId nameId;  // in the owning event's TierNames
+    float price;
+    atomic<int> remaining;
+    atomic<int> held;
+    shared_ptr<SeatMap> seats;  // null for general admission
+    SharedCounts* shared = nullptr;  // used instead of remaining/held when set
+    atomic<int>* listTotal = nullptr;  // set by the TierList holding this tier
+
+    TicketTier(TierId id = 0, float p = 0, int quantity = 0) : nameId(id), price(p), remaining(quantity), held(0) {}
+
+    TicketTier(const TicketTier& other)
+        : nameId(other.nameId), price(other.price), remaining(other.remainingCount().load()),
+          held(other.heldCount().load()), seats(other.seats), shared(other.shared) {}
+
+    // Does not change which list the tier is counted in
+    TicketTier& operator=(const TicketTier& other) {
+        nameId = other.nameId;
+        price = other.price;
+        remaining.store(other.remainingCount().load());
+        held.store(other.heldCount().load());
+        seats = other.seats;
+        shared = other.shared;
+        return *this;
+    }
+
+    int available() const {
+        return remainingCount().load(memory_order_acquire);
+    }
+
+    // Takes quantity tickets if that many are still left. The count never
+    // drops below zero, however many threads race on the same tier.
+    bool tryReserve(int quantity) {
+        int current = remainingCount().load(memory_order_relaxed);
+        while (current >= quantity) {
+            if (remainingCount().compare_exchange_weak(current, current - quantity,
+                                                memory_order_acq_rel, memory_order_relaxed)) {
+                countInList(-quantity);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release(int quantity) {
+        remainingCount().fetch_add(quantity, memory_order_acq_rel);
+        countInList(quantity);
+    }
+
+    // Takes tickets that are already sold, without checking what is left
+    // (replaying the booking journal)
+    void take(int quantity) {
+        remainingCount().fetch_sub(quantity, memory_order_acq_rel);
+        countInList(-quantity);
+    }
+
+    // held goes up after remaining goes down, and down before remaining goes
+    // back up, so a snapshot taken in between can only undercount unsold
+    // tickets, never sell the same ticket twice after a restart.
+    bool tryHold(int quantity) {
+        if (!tryReserve(quantity)) return false;
+        heldCount().fetch_add(quantity, memory_order_acq_rel);
+        return true;
+    }
+
+    void releaseHold(int quantity) {
+        heldCount().fetch_sub(quantity, memory_order_acq_rel);
+        release(quantity);
+    }
+
+    // The held tickets have been sold
+    void confirmHold(int quantity) {
+        heldCount().fetch_sub(quantity, memory_order_acq_rel);
+    }
+
+    // Tickets from a cancelled booking, kept off sale as held until the
+    // waitlist has had its pick (see BookingEngine::promoteWaiting)
+    void holdReturned(int quantity) {
+        heldCount().fetch_add(quantity, memory_order_acq_rel);
+    }
+
+    // What the data files record as remaining: on sale now plus held
+    int unsold() const {
+        return remainingCount().load(memory_order_acquire) + heldCount().load(memory_order_acquire);
+    }
+
+private:
+    atomic<int>& remainingCount() {
+        return shared ? shared->remaining : remaining;
+    }
+
+    const atomic<int>& remainingCount() const {
+        return shared ? shared->remaining : remaining;
+    }
+
+    atomic<int>& heldCount() {
+        return shared ? shared->held : held;
+    }
+
+    const atomic<int>& heldCount() const {
+        return shared ? shared->held : held;
+    }
+
+    void countInList(int delta) {
+        if (listTotal) listTotal->fetch_add(delta, memory_order_relaxed);
+    }
+};
+
+// An event's tiers, in the order they were added. Events rarely have more
+// than a few, so the first INLINE_TIERS are stored inside the TierList (and
+// so inside the Event) with no allocation; a longer list moves to a single
+// heap array. Either way the tiers are contiguous. The list also caches the
+// total number of tickets on sale, which its tiers keep up to date.
+class TierList {
+public:
+    static const size_t INLINE_TIERS = 4;
+
+    TierList() : total(0) {}
+
+    TierList(const TierList& other) : total(0) {
+        copyFrom(other);
+    }
+
+    TierList(TierList&& other) noexcept : total(0) {
+        if (other.isSpilled()) {
+            spilled = move(other.spilled);
+            other.spilled.clear();
+            count = spilled.size();
+            total.store(other.total.load());
+            other.count = 0;
+            other.total.store(0);
+            adopt();
+        } else {
+            copyFrom(other);
+        }
+    }
+
+    TierList& operator=(const TierList& other) {
+        if (this != &other) {
+            spilled.clear();
+            count = 0;
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    TicketTier* begin() { return data(); }
+    TicketTier* end() { return data() + count; }
+    const TicketTier* begin() const { return data(); }
+    const TicketTier* end() const { return data() + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    TicketTier& operator[](size_t i) { return data()[i]; }
+    const TicketTier& operator[](size_t i) const { return data()[i]; }
+
+    // Tickets on sale across all tiers, O(1). Other processes change shared
+    // counts without this list knowing, so those are added up instead.
+    int totalAvailable() const {
+        if (count > 0 && data()[0].shared) {
+            int sum = 0;
+            for (const auto& tier : *this) sum += tier.available();
+            return sum;
+        }
+        return total.load(memory_order_acquire);
+    }
+
+    void push_back(const TicketTier& tier) {
+        if (count < INLINE_TIERS) {
+            inlineTiers[count] = tier;
+            inlineTiers[count].listTotal = &total;
+        } else {
+            if (count == INLINE_TIERS) {
+                spilled.assign(inlineTiers.begin(), inlineTiers.end());
+            }
+            spilled.push_back(tier);
+            adopt();
+        }
+        count++;
+        total.fetch_add(tier.available(), memory_order_acq_rel);
+    }
+
+    // Overwrites tiers[i]; the total follows the new remaining count
+    void replace(size_t i, const TicketTier& tier) {
+        int before = data()[i].available();
+        data()[i] = tier;
+        total.fetch_add(tier.available() - before, memory_order_acq_rel);
+    }
+
+private:
+    array<TicketTier, INLINE_TIERS> inlineTiers;
+    vector<TicketTier> spilled;  // all tiers once there are more than INLINE_TIERS
+    size_t count = 0;
+    atomic<int> total;
+
+    bool isSpilled() const { return count > INLINE_TIERS; }
+    TicketTier* data() { return isSpilled() ? spilled.data() : inlineTiers.data(); }
+    const TicketTier* data() const { return isSpilled() ? spilled.data() : inlineTiers.data(); }
+
+    void copyFrom(const TierList& other) {
+        total.store(0);
+        for (const auto& tier : other) push_back(tier);
+    }
+
+    // Points every tier at this list's total (after the tiers moved)
+    void adopt() {
+        for (auto& tier : spilled) tier.listTotal = &total;
+    }
+};
+
+class Event {
+public:
+    int eventID;
+    string eventName;
+    string eventLocation;
+    string eventDate;
+    int eventDay;  // day number of eventDate, NO_DATE if it does not parse
+    TierList ticketTiers;  // in the order they were added
+    TierNames tierNames;   // what the TierIds of its tiers and bookings stand for
+    
+    Event() : Event(0, "", "", "") {}
+
+    Event(int id, string name, string location, string date) {
+        eventID = id;
+        eventName = name;
+        eventLocation = location;
+        eventDate = date;
+        eventDay = dateToDayNumber(eventDate);
+    }
+
+    // Adding a tier name that already exists replaces that tier. Give a
+    // seat layout (rows x seats per row) for assigned seating. False, with
+    // the event unchanged, if the event's tier name table is full.
+    bool addTicketTier(string tierName, float price, int quantity, int seatRows = 0, int seatsPerRow = 0) {
+        TierId id;
+        if (!tierNames.intern(tierName, id)) return false;
+        TicketTier tier(id, price, quantity);
+        if (seatRows > 0 && seatsPerRow > 0) {
+            tier.seats = make_shared<SeatMap>(seatRows, seatsPerRow);
+        }
+        if (TicketTier* existing = findTier(id)) {
+            ticketTiers.replace(existing - ticketTiers.begin(), tier);
+        } else {
+            ticketTiers.push_back(tier);
+        }
+        return true;
+    }
+
+    TicketTier* findTier(TierId id) {
+        for (auto& tier : ticketTiers) {
+            if (tier.nameId == id) return &tier;
+        }
+        return nullptr;
+    }
+
+    const TicketTier* findTier(TierId id) const {
+        return const_cast<Event*>(this)->findTier(id);
+    }
+
+    TicketTier* findTier(string_view tierName) {
+        TierId id;
+        return tierNames.find(tierName, id) ? findTier(id) : nullptr;
+    }
+
+    const TicketTier* findTier(string_view tierName) const {
+        return const_cast<Event*>(this)->findTier(tierName);
+    }
+
+    const string& tierName(TierId id) const {
+        return tierNames.name(id);
+    }
+
+    const string& tierName(const TicketTier& tier) const {
+        return tierNames.name(tier.nameId);
+    }
+
+    int getTotalTickets() const {
+        return ticketTiers.totalAvailable();
+    }
+
+    void displayEvent() const {
+        cout << "\n===== Event Details =====\n";
+        cout << "Event ID: " << eventID << endl;
+        cout << "Event Name: " << eventName << endl;
+        cout << "Location: " << eventLocation << endl;
+        cout << "Date: " << eventDate << endl;
+        cout << "Available Tickets:\n";
+        for (const auto& tier : ticketTiers) {
+            cout << " - " << tierName(tier) << ": $" << fixed << setprecision(2) 
+                 << tier.price << " (" << tier.available() << " available)\n";
+        }
+        cout << "Total Tickets: " << getTotalTickets() << endl;
+        cout << "======================\n";
+    }
+};
+
+class User {
+public:
+    int UserId;
+    string UserName;
+
+    User() : User(0, "") {}
+
+    User(int id, string name) {
+        UserId = id;
+        UserName = name;
+    }
+
+    void displayUser() const {
+        cout << "\n---- User Information ----\n";
+        cout << "User ID: " << UserId << endl;
+        cout << "User Name: " << UserName << endl;
+        cout << "==============================" << endl;
+    }
+};
+
+// Stored as "Confirmed"/"Cancelled" in bookings.txt. Any other status text
+// counts as cancelled, as it always has in the booking reports.
+enum BookingStatus : uint8_t {
+    STATUS_CONFIRMED,
+    STATUS_CANCELLED
+};
+
+const char* statusName(BookingStatus status) {
+    return status == STATUS_CONFIRMED ? "Confirmed" : "Cancelled";
+}
+
+BookingStatus parseStatus(string_view text) {
+    return text == "Confirmed" ? STATUS_CONFIRMED : STATUS_CANCELLED;
+}
+
+class Booking {
+public:
+    int bookingId;
+    int userId;
+    int eventId;
+    int tickets;
+    float totalPrice;
+    BookingStatus status;
+    TierId tierId;  // in the event's TierNames
+    int seatId;  // first of `tickets` adjacent seats, -1 for general admission
+
+    Booking() : Booking(0, 0, 0, 0, 0, 0) {}
+
+    Booking(int bId, int uId, int eId, int tic, float price, TierId tier, int seat = -1) {
+        bookingId = bId;
+        userId = uId;
+        eventId = eId;
+        tickets = tic;
+        totalPrice = price;
+        status = STATUS_CONFIRMED;
+        tierId = tier;
+        seatId = seat;
+    }
+
+    void displayBooking(const string& ticketTier) const {
+        cout << "\n----- Booking Details -----\n";
+        cout << "Booking ID: " << bookingId << endl;
+        cout << "Event ID: " << eventId << endl;
+        cout << "User ID: " << userId << endl;
+        cout << "Ticket Tier: " << ticketTier << endl;
+        cout << "Tickets: " << tickets << endl;
+        cout << "Total Price: $" << fixed << setprecision(2) << totalPrice << endl;
+        cout << "Status: " << statusName(status) << endl;
+    }
+};
+
+// =============== OPERATIONAL STATS ===============
+// Latency histograms and counters for the booking operations and file I/O.
+// Each thread records into its own histograms (no locks, no shared cache
+// lines); the stats screen and the JSON dump add up all threads' copies.
+//
+// Histograms are HDR-style log-linear: 16 sub-buckets per power of two of
+// nanoseconds, so any recorded value is within 1/16 (6.25%) of the
+// reported one, from 1 ns up to centuries, in 976 buckets.
+enum StatOp {
+    STAT_BOOK,
+    STAT_HOLD,
+    STAT_CONFIRM,
+    STAT_CANCEL,
+    STAT_SAVE_EVENTS,
+    STAT_SAVE_BOOKINGS,
+    STAT_LOAD_USERS,
+    STAT_LOAD_EVENTS,
+    STAT_LOAD_BOOKINGS,
+    STAT_LOAD_SNAPSHOT,
+    STAT_OP_COUNT
+};
+
+const char* const STAT_NAMES[STAT_OP_COUNT] = {
+    "book", "hold", "confirm", "cancel", "save_events", "save_bookings",
+    "load_users", "load_events", "load_bookings", "load_snapshot"
+};
+
+const int HISTOGRAM_SUB_BITS = 4;
+const int HISTOGRAM_SUB_BUCKETS = 1 << HISTOGRAM_SUB_BITS;
+const int HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+inline int highestSetBit(uint64_t value) {
+    #if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+    #else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+    #endif
+}
+
+inline int histogramBucket(uint64_t ns) {
+    if (ns < (uint64_t)HISTOGRAM_SUB_BUCKETS) return ns;
+    int exponent = highestSetBit(ns);
+    int sub = (ns >> (exponent - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in the bucket
+inline uint64_t histogramBucketLimit(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) return bucket;
+    int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t low = (uint64_t)(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+    return low + ((1ull << shift) - 1);
+}
+
+// One thread's counts. Only the owning thread writes, so plain load/store
+// on the atomics is enough; they are atomic so readers see whole values.
+class ThreadStats {
+public:
+    array<array<atomic<uint64_t>, HISTOGRAM_BUCKETS>, STAT_OP_COUNT> buckets{};
+    array<atomic<uint64_t>, STAT_OP_COUNT> totalNs{};
+    array<atomic<uint64_t>, STAT_OP_COUNT> maxNs{};
+
+    void record(StatOp op, uint64_t ns) {
+        bump(buckets[op][histogramBucket(ns)], 1);
+        bump(totalNs[op], ns);
+        if (ns > maxNs[op].load(memory_order_relaxed)) maxNs[op].store(ns, memory_order_relaxed);
+    }
+
+private:
+    static void bump(atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+};
+
+class OpSummary {
+public:
+    uint64_t count = 0;
+    double meanUs = 0;
+    double p50Us = 0;
+    double p90Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+    double perSecond = 0;  // since the program started
+};
+
+class OpStats {
+public:
+    static void record(StatOp op, chrono::steady_clock::duration elapsed) {
+        local().record(op, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+
+    static array<OpSummary, STAT_OP_COUNT> summarize() {
+        array<OpSummary, STAT_OP_COUNT> summaries;
+        double uptime = uptimeSeconds();
+        lock_guard<mutex> guard(lock);
+        for (int op = 0; op < STAT_OP_COUNT; op++) {
+            vector<uint64_t> merged(HISTOGRAM_BUCKETS, 0);
+            uint64_t total = 0;
+            uint64_t maxNs = 0;
+            for (const auto& stats : threads) {
+                for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                    merged[b] += stats->buckets[op][b].load(memory_order_relaxed);
+                }
+                total += stats->totalNs[op].load(memory_order_relaxed);
+                maxNs = max(maxNs, stats->maxNs[op].load(memory_order_relaxed));
+            }
+
+            OpSummary& summary = summaries[op];
+            for (uint64_t count : merged) summary.count += count;
+            if (summary.count == 0) continue;
+            summary.meanUs = total / 1000.0 / summary.count;
+            summary.p50Us = percentile(merged, summary.count, 0.50, maxNs);
+            summary.p90Us = percentile(merged, summary.count, 0.90, maxNs);
+            summary.p99Us = percentile(merged, summary.count, 0.99, maxNs);
+            summary.maxUs = maxNs / 1000.0;
+            summary.perSecond = uptime > 0 ? summary.count / uptime : 0;
+        }
+        return summaries;
+    }
+
+    static double uptimeSeconds() {
+        return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    }
+
+private:
+    inline static mutex lock;
+    inline static vector<unique_ptr<ThreadStats>> threads;  // kept after a thread exits
+    inline static const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+    static ThreadStats& local() {
+        thread_local ThreadStats* stats = nullptr;
+        if (!stats) {
+            lock_guard<mutex> guard(lock);
+            threads.push_back(make_unique<ThreadStats>());
+            stats = threads.back().get();
+        }
+        return *stats;
+    }
+
+    static double percentile(const vector<uint64_t>& buckets, uint64_t count, double p, uint64_t maxNs) {
+        uint64_t rank = max<uint64_t>(1, (uint64_t)ceil(p * count));
+        uint64_t seen = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            seen += buckets[b];
+            if (seen >= rank) return min(histogramBucketLimit(b), maxNs) / 1000.0;
+        }
+        return maxNs / 1000.0;
+    }
+};
+
+// Records how long the enclosing scope took
+class OpTimer {
+public:
+    OpTimer(StatOp statOp) : op(statOp), start(chrono::steady_clock::now()) {}
+
+    ~OpTimer() {
+        OpStats::record(op, chrono::steady_clock::now() - start);
+    }
+
+private:
+    StatOp op;
+    chrono::steady_clock::time_point start;
+};
+
+// {"uptime_seconds":..,"operations":{"book":{"count":..,"per_second":..,
+//  "mean_us":..,"p50_us":..,"p90_us":..,"p99_us":..,"max_us":..},...}}
+string statsJson() {
+    array<OpSummary, STAT_OP_COUNT> summaries = OpStats::summarize();
+    ostringstream json;
+    json << fixed << setprecision(3);
+    json << "{\"uptime_seconds\":" << OpStats::uptimeSeconds() << ",\"operations\":{";
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const OpSummary& s = summaries[op];
+        json << (op ? "," : "") << "\"" << STAT_NAMES[op] << "\":{"
+             << "\"count\":" << s.count
+             << ",\"per_second\":" << s.perSecond
+             << ",\"mean_us\":" << s.meanUs
+             << ",\"p50_us\":" << s.p50Us
+             << ",\"p90_us\":" << s.p90Us
+             << ",\"p99_us\":" << s.p99Us
+             << ",\"max_us\":" << s.maxUs << "}";
+    }
+    json << "}}";
+    return json.str();
+}
+
+// =============== DATA MANAGEMENT ===============
+void ensureFileExists(const string& filename) {
+    ifstream file(filename);
+    if (!file.good()) {
+        ofstream createFile(filename);
+        createFile.close();
+    }
+}
+
+void initializeDataFiles() {
+    ensureFileExists("users.txt");
+    ensureFileExists("events.txt");
+    ensureFileExists("bookings.txt");
+}
+
+// Read-only view of a whole data file. The file is memory-mapped where the
+// platform allows it, otherwise it is read into a buffer in one go.
+class MappedFile {
+public:
+    string_view data;
+
+    MappedFile(const string& filename) {
+        #ifndef _WIN32
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, info.st_size, MADV_SEQUENTIAL);
+                mapping = addr;
+                length = info.st_size;
+                data = string_view((const char*)addr, length);
+            }
+        }
+        ::close(fd);
+        if (mapping) return;
+        #endif
+        ifstream inFile(filename, ios::binary);
+        if (!inFile) return;
+        buffer.assign(istreambuf_iterator<char>(inFile), istreambuf_iterator<char>());
+        data = buffer;
+    }
+
+    ~MappedFile() {
+        #ifndef _WIN32
+        if (mapping) munmap(mapping, length);
+        #endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    size_t lineCount() const {
+        return count(data.begin(), data.end(), '\n') + 1;
+    }
+
+    // Hands out the file one line at a time, like getline. The line ending
+    // is dropped, including the '\r' of files saved with Windows line endings.
+    bool nextLine(string_view& line) {
+        if (pos >= data.size()) return false;
+        size_t end = data.find('\n', pos);
+        if (end == string_view::npos) end = data.size();
+        line = data.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        pos = end + 1;
+        return true;
+    }
+
+private:
+    void* mapping = nullptr;
+    size_t length = 0;
+    size_t pos = 0;
+    string buffer;
+};
+
+// Splits a line on ',' into views of the line. fields keeps its capacity
+// between calls, so steady-state splitting does not allocate.
+void splitFields(string_view line, vector<string_view>& fields) {
+    fields.clear();
+    size_t start = 0;
+    size_t end = line.find(',');
+    while (end != string_view::npos) {
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+        end = line.find(',', start);
+    }
+    fields.push_back(line.substr(start));
+}
+
+// Parses the leading number of a field in place. Accepts what stoi/stof
+// accept: leading whitespace, an optional sign and trailing junk.
+template <typename T>
+bool parseField(string_view field, T& value) {
+    size_t i = 0;
+    while (i < field.size() && isspace((unsigned char)field[i])) i++;
+    if (i < field.size() && field[i] == '+') i++;
+    auto result = from_chars(field.data() + i, field.data() + field.size(), value);
+    return result.ec == errc();
+}
+
+// The data files hold one record per line with ',' between fields. Each
+// record type lists its fields once, in file order, in a RecordFormat
+// specialization, and loading and saving are generated from that list.
+// Fields are parsed in place with from_chars and written with to_chars into
+// the writer's buffer, so neither direction allocates per record.
+
+// Hands out the fields of one line in order
+class FieldReader {
+public:
+    FieldReader(string_view text) : line(text) {}
+
+    // The text up to the next ','; false once the line is used up. A line
+    // ending in ',' has an empty last field.
+    bool next(string_view& field) {
+        if (pos > line.size()) return false;
+        size_t end = line.find(',', pos);
+        if (end == string_view::npos) end = line.size();
+        field = line.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+
+    // Everything not read yet, ',' included
+    string_view rest() {
+        string_view remaining = atEnd() ? string_view() : line.substr(pos);
+        pos = line.size() + 1;
+        return remaining;
+    }
+
+    bool atEnd() const {
+        return pos > line.size();
+    }
+
+private:
+    string_view line;
+    size_t pos = 0;
+};
+
+// Builds records in one buffer, which goes to the file in large blocks
+class RecordWriter {
+public:
+    RecordWriter(const string& filename) : file(filename) {
+        buffer.reserve(BLOCK_SIZE + BLOCK_SIZE / 4);
+    }
+
+    ~RecordWriter() {
+        close();
+    }
+
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
+
+    explicit operator bool() const {
+        return file.is_open() && !file.fail();
+    }
+
+    // Starts a field: all but the first field of a record follow a ','
+    void field() {
+        if (fieldsInRecord++) buffer += ',';
+    }
+
+    void put(string_view text) {
+        buffer.append(text);
+    }
+
+    void put(char c) {
+        buffer += c;
+    }
+
+    void put(int value) {
+        putChars(value);
+    }
+
+    // Prices, always with two decimals
+    void put(float value) {
+        putChars(value, chars_format::fixed, 2);
+    }
+
+    void put(BookingStatus status) {
+        put(statusName(status));
+    }
+
+    void endRecord() {
+        buffer += '\n';
+        fieldsInRecord = 0;
+        if (buffer.size() >= BLOCK_SIZE) flush();
+    }
+
+    // Writes out what is left; false if any of the file could not be written
+    bool close() {
+        if (file.is_open()) {
+            flush();
+            file.close();
+        }
+        return !file.fail();
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    ofstream file;
+    string buffer;
+    int fieldsInRecord = 0;
+
+    template <typename T, typename... Format>
+    void putChars(T value, Format... format) {
+        char chars[64];
+        auto result = to_chars(chars, chars + sizeof chars, value, format...);
+        buffer.append(chars, result.ptr - chars);
+    }
+
+    void flush() {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+};
+
+inline bool decodeField(string_view text, int& value) {
+    return parseField(text, value);
+}
+
+inline bool decodeField(string_view text, float& value) {
+    return parseField(text, value);
+}
+
+inline bool decodeField(string_view text, string& value) {
+    value.assign(text);
+    return true;
+}
+
+inline bool decodeField(string_view text, BookingStatus& status) {
+    status = parseStatus(text);
+    return true;
+}
+
+// A member stored as one field
+template <auto Member>
+class Field {
+public:
+    template <typename Record, typename... Context>
+    static bool read(FieldReader& in, Record& record, Context&...) {
+        string_view text;
+        return in.next(text) && decodeField(text, record.*Member);
+    }
+
+    template <typename Record, typename... Context>
+    static void write(RecordWriter& out, const Record& record, Context&...) {
+        out.field();
+        out.put(record.*Member);
+    }
+};
+
+// A text member that runs to the end of the line, so it may contain ','
+template <auto Member>
+class RestField {
+public:
+    template <typename Record, typename... Context>
+    static bool read(FieldReader& in, Record& record, Context&...) {
+        if (in.atEnd()) return false;
+        (record.*Member).assign(in.rest());
+        return true;
+    }
+
+    template <typename Record, typename... Context>
+    static void write(RecordWriter& out, const Record& record, Context&...) {
+        out.field();
+        out.put(record.*Member);
+    }
+};
+
+// A last field that is left out while the member holds absent
+template <auto Member, auto absent>
+class OptionalField {
+public:
+    template <typename Record, typename... Context>
+    static bool read(FieldReader& in, Record& record, Context&...) {
+        string_view text;
+        if (!in.next(text)) {
+            record.*Member = absent;
+            return true;
+        }
+        return decodeField(text, record.*Member);
+    }
+
+    template <typename Record, typename... Context>
+    static void write(RecordWriter& out, const Record& record, Context&...) {
+        if (record.*Member == absent) return;
+        out.field();
+        out.put(record.*Member);
+    }
+};
+
+// A TierId member, stored as the tier's name and looked up in the tier
+// names of the record's eventId through the file's TierScope. Names the
+// event has not seen are interned, or with internNew false make the record
+// invalid; so does a new name when the event's table is full.
+template <auto Member, bool internNew = true>
+class TierField {
+public:
+    template <typename Record, typename Scope>
+    static bool read(FieldReader& in, Record& record, Scope& tiers) {
+        string_view text;
+        if (!in.next(text)) return false;
+        if (internNew) return tiers.intern(record.eventId, text, record.*Member);
+        return tiers.find(record.eventId, text, record.*Member);
+    }
+
+    template <typename Record, typename Scope>
+    static void write(RecordWriter& out, const Record& record, const Scope& tiers) {
+        out.field();
+        out.put(tiers.name(record.eventId, record.*Member));
+    }
+};
+
+// eventDate, with eventDay worked out from it as it is read
+class EventDateField {
+public:
+    static bool read(FieldReader& in, Event& event) {
+        string_view text;
+        if (!in.next(text)) return false;
+        event.eventDate.assign(text);
+        event.eventDay = dateToDayNumber(event.eventDate);
+        return true;
+    }
+
+    static void write(RecordWriter& out, const Event& event) {
+        out.field();
+        out.put(event.eventDate);
+    }
+};
+
+// The rest of an event's line, one field per tier:
+// <tier>:<price>:<quantity>[@<rows>x<seats per row>]. Fields without a ':'
+// are skipped; a tier whose numbers do not parse, whose seat layout is not one
+// a SeatMap can hold, or whose name cannot be interned makes the event invalid.
+class EventTiersField {
+public:
+    static bool read(FieldReader& in, Event& event) {
+        string_view tier;
+        while (in.next(tier)) {
+            size_t firstColon = tier.find(':');
+            size_t secondColon = tier.rfind(':');
+            if (firstColon == string_view::npos) continue;
+
+            // With a single colon the old loader read price and quantity from
+            // the same text; keep accepting that.
+            string_view priceField = firstColon == secondColon
+                ? tier.substr(firstColon + 1)
+                : tier.substr(firstColon + 1, secondColon - firstColon - 1);
+            float price;
+            int quantity;
+            if (!parseField(priceField, price) || !parseField(tier.substr(secondColon + 1), quantity)) {
+                return false;
+            }
+            int seatRows = 0, seatsPerRow = 0;
+            size_t at = tier.find('@', secondColon);
+            if (at != string_view::npos) {
+                size_t x = tier.find('x', at);
+                if (x == string_view::npos || !parseField(tier.substr(at + 1, x - at - 1), seatRows) ||
+                    !parseField(tier.substr(x + 1), seatsPerRow) || !SeatMap::validLayout(seatRows, seatsPerRow)) {
+                    return false;
+                }
+            }
+            if (!event.addTicketTier(string(tier.substr(0, firstColon)), price, quantity, seatRows, seatsPerRow)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void write(RecordWriter& out, const Event& event) {
+        for (const auto& tier : event.ticketTiers) {
+            out.field();
+            out.put(event.tierName(tier));
+            out.put(':');
+            out.put(tier.price);
+            out.put(':');
+            out.put(tier.unsold());
+            if (tier.seats) {
+                out.put('@');
+                out.put(tier.seats->rows);
+                out.put('x');
+                out.put(tier.seats->seatsPerRow);
+            }
+        }
+    }
+};
+
+// A record's fields in file order. A line is valid only if every field
+// reads and nothing is left over.
+// Fields that need more than the record to be read or written (a TierField
+// needs the events' tier names) take it as context, passed on to every field.
+template <typename... Fields>
+class Columns {
+public:
+    template <typename Record, typename... Context>
+    static bool read(string_view line, Record& record, Context&... context) {
+        FieldReader in(line);
+        return (Fields::read(in, record, context...) && ...) && in.atEnd();
+    }
+
+    template <typename Record, typename... Context>
+    static void write(RecordWriter& out, const Record& record, Context&... context) {
+        (Fields::write(out, record, context...), ...);
+        out.endRecord();
+    }
+};
+
+// Specialized for each record type kept in a data file
+template <typename Record>
+class RecordFormat;
+
+// users.txt: userId,name
+template <>
+class RecordFormat<User> : public Columns<
+    Field<&User::UserId>,
+    RestField<&User::UserName>> {};
+
+// events.txt: eventId,name,location,date[,tier...]
+template <>
+class RecordFormat<Event> : public Columns<
+    Field<&Event::eventID>,
+    Field<&Event::eventName>,
+    Field<&Event::eventLocation>,
+    EventDateField,
+    EventTiersField> {
+public:
+    // A trailing ',' has never started another field in events.txt
+    static bool read(string_view line, Event& event) {
+        if (!line.empty() && line.back() == ',') line.remove_suffix(1);
+        return Columns::read(line, event);
+    }
+};
+
+// bookings.txt: bookingId,userId,eventId,tickets,totalPrice,status,tier[,seatId]
+template <>
+class RecordFormat<Booking> : public Columns<
+    Field<&Booking::bookingId>,
+    Field<&Booking::userId>,
+    Field<&Booking::eventId>,
+    Field<&Booking::tickets>,
+    Field<&Booking::totalPrice>,
+    Field<&Booking::status>,
+    TierField<&Booking::tierId>,
+    OptionalField<&Booking::seatId, -1>> {};
+
+// Appends the records in a data file to records, skipping lines that do
+// not parse. A missing file adds nothing.
+template <typename Record, typename... Context>
+void loadRecords(const string& filename, vector<Record>& records, Context&... context) {
+    MappedFile file(filename);
+    records.reserve(records.size() + file.lineCount());
+
+    string_view line;
+    while (file.nextLine(line)) {
+        // Built in place: an Event's tiers are stored inside it, so moving one costs a copy
+        Record& record = records.emplace_back();
+        if (!RecordFormat<Record>::read(line, record, context...)) records.pop_back();
+    }
+}
+
+// Replaces filename with records, which can be any range of one record
+// type. False if the file could not be written.
+template <typename Records, typename... Context>
+bool saveRecords(const Records& records, const string& filename, Context&... context) {
+    RecordWriter out(filename);
+    if (!out) return false;
+    for (const auto& record : records) {
+        RecordFormat<decay_t<decltype(record)>>::write(out, record, context...);
+    }
+    return out.close();
+}
+
+void saveUsers(const vector<User>& Userlist) {
+    if (!saveRecords(Userlist, "users.txt")) {
+        cerr << "Error saving users\n";
+    }
+}
+
+void saveEvents(const vector<Event>& eventlist, const string& filename = "events.txt") {
+    OpTimer timer(STAT_SAVE_EVENTS);
+    if (!saveRecords(eventlist, filename)) {
+        cerr << "Error saving events\n";
+    }
+}
+
+// The tier names of a list of events by event id, for records that name
+// their event's tier (bookings, waitlist entries) as they are read and
+// written. Built over a list that does not change while it is used.
+class TierScope {
+public:
+    explicit TierScope(const vector<Event>& eventlist) : events(&eventlist) {
+        positions.reserve(eventlist.size());
+        for (size_t i = 0; i < eventlist.size(); i++) positions.emplace(eventlist[i].eventID, i);
+    }
+
+    // Interning needs a list it can change
+    explicit TierScope(vector<Event>& eventlist) : TierScope((const vector<Event>&)eventlist) {
+        writable = &eventlist;
+    }
+
+    const string& name(int eventId, TierId id) const {
+        auto it = positions.find(eventId);
+        if (it != positions.end()) return (*events)[it->second].tierName(id);
+        static const TierNames none;
+        auto stray = strays().find(eventId);
+        return (stray != strays().end() ? stray->second : none).name(id);
+    }
+
+    bool find(int eventId, string_view tierName, TierId& id) const {
+        auto it = positions.find(eventId);
+        return it != positions.end() && (*events)[it->second].tierNames.find(tierName, id);
+    }
+
+    bool intern(int eventId, string_view tierName, TierId& id) {
+        auto it = positions.find(eventId);
+        if (it == positions.end()) return strays()[eventId].intern(tierName, id);
+        return writable && (*writable)[it->second].tierNames.intern(tierName, id);
+    }
+
+private:
+    const vector<Event>* events;
+    vector<Event>* writable = nullptr;
+    unordered_map<int, size_t> positions;
+
+    // Names for bookings whose event is not in the list, which only a
+    // hand-edited bookings.txt holds, so they are written back as they were
+    // read. Only filled in while loading.
+    static unordered_map<int, TierNames>& strays() {
+        static unordered_map<int, TierNames> names;
+        return names;
+    }
+};
+
+// Bookings: a vector or a BookingSnapshot, with the events they belong to
+template <typename Bookings>
+void saveBookings(const Bookings& bookings, const vector<Event>& eventlist,
+                  const string& filename = "bookings.txt") {
+    OpTimer timer(STAT_SAVE_BOOKINGS);
+    TierScope tiers(eventlist);
+    if (!saveRecords(bookings, filename, tiers)) {
+        cerr << "Error saving bookings\n";
+    }
+}
+
+vector<User> loadUsers() {
+    OpTimer timer(STAT_LOAD_USERS);
+    vector<User> Userlist;
+    loadRecords("users.txt", Userlist);
+    return Userlist;
+}
+
+vector<Event> loadEvents() {
+    OpTimer timer(STAT_LOAD_EVENTS);
+    vector<Event> eventlist;
+    loadRecords("events.txt", eventlist);
+    return eventlist;
+}
+
+// Tier names the events do not have yet are added to them
+vector<Booking> loadBookings(vector<Event>& eventlist) {
+    OpTimer timer(STAT_LOAD_BOOKINGS);
+    vector<Booking> bookings;
+    TierScope tiers(eventlist);
+    loadRecords("bookings.txt", bookings, tiers);
+    return bookings;
+}
+
+// Strict form of the tier parsing in EventTiersField for input from outside
+// the program (scripts, imports): <tier>:<price>:<quantity>[@<rows>x<seats>]
+// with no negative numbers and a seat layout big enough for the tickets. Adds
+// the tier to event; returns what is wrong with it, or nullptr if it was added.
+const char* parseTier(string_view tier, Event& event) {
+    size_t firstColon = tier.find(':');
+    size_t secondColon = tier.rfind(':');
+    float price;
+    int quantity;
+    if (firstColon == string_view::npos || firstColon == secondColon || firstColon == 0 ||
+        !parseField(tier.substr(firstColon + 1, secondColon - firstColon - 1), price) ||
+        !parseField(tier.substr(secondColon + 1), quantity) || price < 0 || quantity < 0) {
+        return "BAD_TIER";
+    }
+    int seatRows = 0, seatsPerRow = 0;
+    size_t at = tier.find('@', secondColon);
+    if (at != string_view::npos) {
+        size_t x = tier.find('x', at);
+        if (x == string_view::npos || !parseField(tier.substr(at + 1, x - at - 1), seatRows) ||
+            !parseField(tier.substr(x + 1), seatsPerRow) || !SeatMap::validLayout(seatRows, seatsPerRow) ||
+            quantity > seatRows * seatsPerRow) {
+            return "BAD_TIER";
+        }
+    }
+    if (!event.addTicketTier(string(tier.substr(0, firstColon)), price, quantity, seatRows, seatsPerRow)) {
+        return "TOO_MANY_TIERS";
+    }
+    return nullptr;
+}
+
+int getNextEventID(const vector<Event>& eventlist) {
+    if (eventlist.empty()) return 1;
+    int maxID = 0;
+    for (const auto& event : eventlist) {
+        if (event.eventID > maxID) maxID = event.eventID;
+    }
+    return maxID + 1;
+}
+
+int getnextUserID(const vector<User>& Userlist) {
+    if (Userlist.empty()) return 1;
+    int maxID = 0;
+    for (const auto& user : Userlist) {
+        if (user.UserId > maxID) maxID = user.UserId;
+    }
+    return maxID + 1;
+}
+
+// =============== BINARY SNAPSHOT ===============
+// data.snapshot holds users, events (with tiers) and bookings in a compact
+// binary form so startup does not have to re-parse the text files. It is
+// written next to the .txt files at every engine checkpoint and on exit.
+// Journal compaction writes one too, right after the .txt files it rewrites.
+// It is only trusted while the .txt files still have the size and
+// modification time they had when it was written; otherwise the text files
+// are loaded as before.
+//
+// Layout: SnapshotHeader, then fixed-width little-endian columns in the order
+// listed in writeSnapshotFile, then a pool of string bytes. Strings in the
+// columns are (offset, length) pairs into the pool; repeated strings such as
+// statuses and tier names are stored once. The checksum is FNV-1a over the
+// header's counts and everything after the header.
+const char SNAPSHOT_MAGIC[8] = {'E', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint32_t SNAPSHOT_VERSION = 4;
+
+struct SourceStamp {
+    uint64_t size;
+    int64_t modified;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t userCount;
+    uint64_t eventCount;
+    uint64_t tierCount;
+    uint64_t bookingCount;
+    uint64_t poolSize;
+    SourceStamp sources[3];  // users.txt, events.txt, bookings.txt
+    uint64_t checksum;
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+const char* const SNAPSHOT_SOURCES[3] = {"users.txt", "events.txt", "bookings.txt"};
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// The counts (userCount through poolSize) are checksummed with the body, so
+// a torn header is caught before they size any allocation. This is the hash
+// of the counts, to chain the body's hash from.
+uint64_t snapshotCountsHash(const SnapshotHeader& header) {
+    const char* counts = (const char*)&header.userCount;
+    return fnv1a(counts, (const char*)&header.sources - counts);
+}
+
+SourceStamp stampFile(const string& filename) {
+    error_code ec;
+    SourceStamp stamp = {0, 0};
+    stamp.size = filesystem::file_size(filename, ec);
+    if (ec) return {0, 0};
+    stamp.modified = filesystem::last_write_time(filename, ec).time_since_epoch().count();
+    return stamp;
+}
+
+class SnapshotWriter {
+public:
+    vector<char> columns;
+    string pool;
+    unordered_map<string, uint32_t> pooled;
+
+    template <typename T>
+    void put(const T& value) {
+        const char* bytes = (const char*)&value;
+        columns.insert(columns.end(), bytes, bytes + sizeof(T));
+    }
+
+    void putString(const string& text) {
+        auto it = pooled.find(text);
+        StringRef ref;
+        ref.length = text.size();
+        if (it != pooled.end()) {
+            ref.offset = it->second;
+        } else {
+            ref.offset = pool.size();
+            pooled.emplace(text, ref.offset);
+            pool += text;
+        }
+        put(ref);
+    }
+};
+
+class SnapshotReader {
+public:
+    const char* cursor;
+    const char* end;
+    string_view pool;
+
+    template <typename T>
+    bool get(T& value) {
+        if (end - cursor < (ptrdiff_t)sizeof(T)) return false;
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    bool getString(string& text) {
+        StringRef ref;
+        if (!get(ref) || (uint64_t)ref.offset + ref.length > pool.size()) return false;
+        text.assign(pool.data() + ref.offset, ref.length);
+        return true;
+    }
+};
+
+// Bookings: a vector or a BookingSnapshot. usersStamp is users.txt's stamp
+// as of when Userlist was copied, for a snapshot written on another thread
+// while users.txt may be rewritten; otherwise it is stamped here.
+template <typename Bookings>
+bool writeSnapshotFile(const vector<User>& Userlist, const vector<Event>& eventlist,
+                       const Bookings& bookings, const string& filename = "data.snapshot",
+                       const SourceStamp* usersStamp = nullptr) {
+    SnapshotWriter writer;
+    uint64_t tierCount = 0;
+    for (const auto& event : eventlist) tierCount += event.ticketTiers.size();
+
+    // Users: id, name
+    for (const auto& user : Userlist) writer.put<int32_t>(user.UserId);
+    for (const auto& user : Userlist) writer.putString(user.UserName);
+
+    // Events: id, name, location, date, tier count
+    for (const auto& event : eventlist) writer.put<int32_t>(event.eventID);
+    for (const auto& event : eventlist) writer.putString(event.eventName);
+    for (const auto& event : eventlist) writer.putString(event.eventLocation);
+    for (const auto& event : eventlist) writer.putString(event.eventDate);
+    for (const auto& event : eventlist) writer.put<uint32_t>(event.ticketTiers.size());
+
+    // Tiers, event by event: name, price, remaining, seat rows, seats per row
+    for (const auto& event : eventlist)
+        for (const auto& tier : event.ticketTiers) writer.putString(event.tierName(tier));
+    for (const auto& event : eventlist)
+        for (const auto& tier : event.ticketTiers) writer.put<float>(tier.price);
+    for (const auto& event : eventlist)
+        for (const auto& tier : event.ticketTiers) writer.put<int32_t>(tier.unsold());
+    for (const auto& event : eventlist)
+        for (const auto& tier : event.ticketTiers) writer.put<int32_t>(tier.seats ? tier.seats->rows : 0);
+    for (const auto& event : eventlist)
+        for (const auto& tier : event.ticketTiers) writer.put<int32_t>(tier.seats ? tier.seats->seatsPerRow : 0);
+
+    // Bookings: id, user, event, tickets, total price, status, tier, seat
+    for (const auto& booking : bookings) writer.put<int32_t>(booking.bookingId);
+    for (const auto& booking : bookings) writer.put<int32_t>(booking.userId);
+    for (const auto& booking : bookings) writer.put<int32_t>(booking.eventId);
+    for (const auto& booking : bookings) writer.put<int32_t>(booking.tickets);
+    for (const auto& booking : bookings) writer.put<float>(booking.totalPrice);
+    for (const auto& booking : bookings) writer.put<uint8_t>(booking.status);
+    TierScope tiers(eventlist);
+    for (const auto& booking : bookings) writer.putString(tiers.name(booking.eventId, booking.tierId));
+    for (const auto& booking : bookings) writer.put<int32_t>(booking.seatId);
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.userCount = Userlist.size();
+    header.eventCount = eventlist.size();
+    header.tierCount = tierCount;
+    header.bookingCount = bookings.size();
+    header.poolSize = writer.pool.size();
+    for (int i = 0; i < 3; i++) {
+        header.sources[i] = stampFile(SNAPSHOT_SOURCES[i]);
+    }
+    if (usersStamp) header.sources[0] = *usersStamp;
+    header.checksum = fnv1a(writer.pool.data(), writer.pool.size(),
+                            fnv1a(writer.columns.data(), writer.columns.size(), snapshotCountsHash(header)));
+
+    string tmpName = filename + ".tmp";
+    ofstream outFile(tmpName, ios::binary | ios::trunc);
+    if (!outFile) {
+        cerr << "Error saving snapshot\n";
+        return false;
+    }
+    outFile.write((const char*)&header, sizeof(header));
+    outFile.write(writer.columns.data(), writer.columns.size());
+    outFile.write(writer.pool.data(), writer.pool.size());
+    outFile.close();
+    if (!outFile) {
+        remove(tmpName.c_str());
+        return false;
+    }
+    return rename(tmpName.c_str(), filename.c_str()) == 0;
+}
+
+// Loads the snapshot if it is present, intact and still matches the .txt
+// files (unless checkSources is false). Leaves the vectors untouched on failure.
+bool loadSnapshotFile(vector<User>& Userlist, vector<Event>& eventlist, vector<Booking>& bookings,
+                      const string& filename = "data.snapshot", bool checkSources = true) {
+    OpTimer timer(STAT_LOAD_SNAPSHOT);
+    MappedFile file(filename);
+    if (file.data.size() < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header;
+    memcpy(&header, file.data.data(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.headerSize != sizeof(SnapshotHeader)) {
+        return false;
+    }
+    if (checkSources) {
+        for (int i = 0; i < 3; i++) {
+            SourceStamp current = stampFile(SNAPSHOT_SOURCES[i]);
+            if (current.size != header.sources[i].size || current.modified != header.sources[i].modified) {
+                return false;
+            }
+        }
+    }
+
+    const char* body = file.data.data() + sizeof(header);
+    size_t bodySize = file.data.size() - sizeof(header);
+    if (header.poolSize > bodySize || fnv1a(body, bodySize, snapshotCountsHash(header)) != header.checksum) return false;
+
+    // Every row takes at least a few bytes of column data; counts the columns
+    // cannot hold mean the file was not written by us
+    size_t columnsSize = bodySize - header.poolSize;
+    if (header.userCount > columnsSize / (sizeof(int32_t) + sizeof(StringRef)) ||
+        header.eventCount > columnsSize / (sizeof(int32_t) * 2 + sizeof(StringRef) * 3) ||
+        header.tierCount > columnsSize / (sizeof(StringRef) + sizeof(float) + sizeof(int32_t) * 3) ||
+        header.bookingCount > columnsSize / (sizeof(int32_t) * 5 + sizeof(uint8_t) + sizeof(StringRef))) {
+        return false;
+    }
+
+    SnapshotReader reader;
+    reader.cursor = body;
+    reader.end = body + bodySize - header.poolSize;
+    reader.pool = string_view(reader.end, header.poolSize);
+
+    vector<User> users;
+    vector<Event> events;
+    vector<Booking> bookingList;
+    users.reserve(header.userCount);
+    events.reserve(header.eventCount);
+    bookingList.reserve(header.bookingCount);
+    bool ok = true;
+
+    for (uint64_t i = 0; i < header.userCount && ok; i++) {
+        int32_t id = 0;
+        ok = reader.get(id);
+        users.emplace_back(id, "");
+    }
+    for (auto& user : users) ok = ok && reader.getString(user.UserName);
+
+    for (uint64_t i = 0; i < header.eventCount && ok; i++) {
+        int32_t id = 0;
+        ok = reader.get(id);
+        events.emplace_back(id, "", "", "");
+    }
+    for (auto& event : events) ok = ok && reader.getString(event.eventName);
+    for (auto& event : events) ok = ok && reader.getString(event.eventLocation);
+    for (auto& event : events) {
+        ok = ok && reader.getString(event.eventDate);
+        event.eventDay = dateToDayNumber(event.eventDate);
+    }
+    vector<uint32_t> tiersPerEvent(events.size());
+    for (auto& count : tiersPerEvent) ok = ok && reader.get(count);
+
+    vector<string> tierNames(header.tierCount);
+    vector<float> tierPrices(header.tierCount);
+    vector<int32_t> tierRemaining(header.tierCount);
+    vector<int32_t> tierSeatRows(header.tierCount);
+    vector<int32_t> tierSeatsPerRow(header.tierCount);
+    for (auto& name : tierNames) ok = ok && reader.getString(name);
+    for (auto& price : tierPrices) ok = ok && reader.get(price);
+    for (auto& remaining : tierRemaining) ok = ok && reader.get(remaining);
+    for (auto& rows : tierSeatRows) ok = ok && reader.get(rows);
+    for (auto& perRow : tierSeatsPerRow) ok = ok && reader.get(perRow);
+    size_t tier = 0;
+    for (size_t i = 0; i < events.size() && ok; i++) {
+        for (uint32_t t = 0; t < tiersPerEvent[i] && tier < tierNames.size(); t++, tier++) {
+            bool seated = tierSeatRows[tier] != 0 || tierSeatsPerRow[tier] != 0;
+            ok = ok && (!seated || SeatMap::validLayout(tierSeatRows[tier], tierSeatsPerRow[tier]));
+            ok = ok && events[i].addTicketTier(tierNames[tier], tierPrices[tier], tierRemaining[tier],
+                                               tierSeatRows[tier], tierSeatsPerRow[tier]);
+        }
+    }
+
+    for (uint64_t i = 0; i < header.bookingCount && ok; i++) {
+        int32_t id = 0;
+        ok = reader.get(id);
+        bookingList.emplace_back(id, 0, 0, 0, 0.0f, 0);
+    }
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.userId);
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.eventId);
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.tickets);
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.totalPrice);
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.status);
+    string tierName;
+    TierScope tiers(events);
+    for (auto& booking : bookingList) {
+        ok = ok && reader.getString(tierName) && tiers.intern(booking.eventId, tierName, booking.tierId);
+    }
+    for (auto& booking : bookingList) ok = ok && reader.get(booking.seatId);
+
+    if (!ok || tier != header.tierCount || reader.cursor != reader.end) return false;
+
+    Userlist = move(users);
+    eventlist = move(events);
+    bookings = move(bookingList);
+    return true;
+}
+
+// The binary snapshot if it is up to date, otherwise the .txt files
+void loadDataFiles(vector<User>& Userlist, vector<Event>& eventlist, vector<Booking>& bookings) {
+    if (!loadSnapshotFile(Userlist, eventlist, bookings)) {
+        eventlist = loadEvents();
+        Userlist = loadUsers();
+        bookings = loadBookings(eventlist);
+    }
+}
+
+// =============== SEARCH INDEX ===============
+// Inverted index over event names and locations. Text is split into
+// lower-case alphanumeric tokens; each token maps to the events (eventlist
+// positions) it appears in and whether it is in the name, the location or
+// both. The token dictionary is sorted, so a prefix is a contiguous range of
+// it (typeahead), and every token is also filed under its character
+// trigrams so a term can match inside a longer token ("expo" in "artexpo").
+//
+// Every query term has to match. A term scores per event: 2 for the name,
+// 1 for the location, doubled for a whole-token match, halved for a match
+// inside a token. Events with equal scores keep the order they were added.
+class SearchHit {
+public:
+    size_t eventPos;
+    double score;
+};
+
+class EventSearch {
+public:
+    static constexpr uint8_t IN_NAME = 1;
+    static constexpr uint8_t IN_LOCATION = 2;
+
+    void clear() {
+        postings.clear();
+        trigrams.clear();
+    }
+
+    void addEvent(const Event& event, size_t pos) {
+        vector<pair<string, uint8_t>> tokens;
+        for (auto& token : tokenize(event.eventName)) tokens.emplace_back(move(token), IN_NAME);
+        for (auto& token : tokenize(event.eventLocation)) tokens.emplace_back(move(token), IN_LOCATION);
+
+        for (auto& [token, field] : tokens) {
+            auto [it, added] = postings.try_emplace(token);
+            if (added) fileTrigrams(it->first);
+            vector<Posting>& list = it->second;
+            if (!list.empty() && list.back().eventPos == pos) {
+                list.back().fields |= field;
+            } else {
+                list.push_back({(uint32_t)pos, field});
+            }
+        }
+    }
+
+    // All matching events, best first
+    vector<SearchHit> search(string_view query) const {
+        vector<string> terms = tokenize(query);
+        if (terms.empty()) return {};
+
+        unordered_map<size_t, double> scores;
+        for (size_t t = 0; t < terms.size(); t++) {
+            unordered_map<size_t, double> termScores = scoreTerm(terms[t]);
+            if (t == 0) {
+                scores = move(termScores);
+                continue;
+            }
+            // Keep only events that also match this term
+            for (auto it = scores.begin(); it != scores.end();) {
+                auto match = termScores.find(it->first);
+                if (match == termScores.end()) {
+                    it = scores.erase(it);
+                } else {
+                    it->second += match->second;
+                    ++it;
+                }
+            }
+        }
+
+        vector<SearchHit> hits;
+        hits.reserve(scores.size());
+        for (const auto& [pos, score] : scores) hits.push_back({pos, score});
+        sort(hits.begin(), hits.end(), [](const SearchHit& a, const SearchHit& b) {
+            return a.score != b.score ? a.score > b.score : a.eventPos < b.eventPos;
+        });
+        return hits;
+    }
+
+    static vector<string> tokenize(string_view text) {
+        vector<string> tokens;
+        string token;
+        for (char c : text) {
+            if (isalnum((unsigned char)c)) {
+                token += tolower((unsigned char)c);
+            } else if (!token.empty()) {
+                tokens.push_back(move(token));
+                token.clear();
+            }
+        }
+        if (!token.empty()) tokens.push_back(move(token));
+        return tokens;
+    }
+
+private:
+    struct Posting {
+        uint32_t eventPos;
+        uint8_t fields;
+    };
+
+    map<string, vector<Posting>> postings;  // sorted for prefix ranges
+    unordered_map<uint32_t, vector<const string*>> trigrams;  // keys of postings
+
+    static uint32_t trigramKey(const string& text, size_t i) {
+        return (uint8_t)text[i] << 16 | (uint8_t)text[i + 1] << 8 | (uint8_t)text[i + 2];
+    }
+
+    void fileTrigrams(const string& token) {
+        for (size_t i = 0; i + 3 <= token.size(); i++) {
+            vector<const string*>& tokens = trigrams[trigramKey(token, i)];
+            if (tokens.empty() || tokens.back() != &token) tokens.push_back(&token);
+        }
+    }
+
+    static void addScore(unordered_map<size_t, double>& scores, const vector<Posting>& list, double weight) {
+        for (const Posting& posting : list) {
+            double score = weight * ((posting.fields & IN_NAME ? 2 : 0) + (posting.fields & IN_LOCATION ? 1 : 0));
+            double& best = scores[posting.eventPos];
+            best = max(best, score);
+        }
+    }
+
+    unordered_map<size_t, double> scoreTerm(const string& term) const {
+        unordered_map<size_t, double> scores;
+
+        // Whole tokens and tokens starting with the term
+        for (auto it = postings.lower_bound(term);
+             it != postings.end() && it->first.compare(0, term.size(), term) == 0; ++it) {
+            addScore(scores, it->second, it->first.size() == term.size() ? 2.0 : 1.0);
+        }
+
+        // Tokens containing the term further in: check the tokens under the
+        // term's rarest trigram
+        if (term.size() >= 3) {
+            const vector<const string*>* candidates = nullptr;
+            for (size_t i = 0; i + 3 <= term.size(); i++) {
+                auto it = trigrams.find(trigramKey(term, i));
+                if (it == trigrams.end()) return scores;
+                if (!candidates || it->second.size() < candidates->size()) candidates = &it->second;
+            }
+            for (const string* token : *candidates) {
+                size_t at = token->find(term);
+                if (at != string::npos && at > 0) addScore(scores, postings.at(*token), 0.5);
+            }
+        }
+        return scores;
+    }
+};
+
+// =============== INDEXES ===============
+// Hash indexes from UserId, eventID and bookingId to the record's position in
+// Userlist, eventlist and bookings. Positions (not pointers) are stored so the
+// index stays valid when the vectors grow. Every insert into one of the three
+// vectors must go through the matching add* call.
+class DataIndex {
+public:
+    unordered_map<int, size_t> userById;
+    unordered_map<int, size_t> eventById;
+    unordered_map<int, size_t> bookingById;
+    unordered_map<int, vector<size_t>> bookingsByUser;
+    multimap<int, size_t> eventsByDate;  // day number -> eventlist position
+    EventSearch search;  // event names and locations
+
+    void rebuild(const vector<User>& Userlist, const vector<Event>& eventlist, const vector<Booking>& bookings) {
+        userById.clear();
+        eventById.clear();
+        bookingById.clear();
+        bookingsByUser.clear();
+        eventsByDate.clear();
+        search.clear();
+        userById.reserve(Userlist.size());
+        eventById.reserve(eventlist.size());
+        bookingById.reserve(bookings.size());
+
+        for (size_t i = 0; i < Userlist.size(); i++) addUser(Userlist, i);
+        for (size_t i = 0; i < eventlist.size(); i++) addEvent(eventlist, i);
+        for (size_t i = 0; i < bookings.size(); i++) addBooking(bookings, i);
+    }
+
+    // On duplicate ids the first record wins, matching the old linear scans.
+    void addUser(const vector<User>& Userlist, size_t pos) {
+        userById.emplace(Userlist[pos].UserId, pos);
+    }
+
+    void addEvent(const vector<Event>& eventlist, size_t pos) {
+        if (!eventById.emplace(eventlist[pos].eventID, pos).second) return;
+        if (eventlist[pos].eventDay != NO_DATE) {
+            eventsByDate.emplace(eventlist[pos].eventDay, pos);
+        }
+        search.addEvent(eventlist[pos], pos);
+    }
+
+    void addBooking(const vector<Booking>& bookings, size_t pos) {
+        if (bookingById.emplace(bookings[pos].bookingId, pos).second) {
+            bookingsByUser[bookings[pos].userId].push_back(pos);
+        }
+    }
+
+    const User* findUser(const vector<User>& Userlist, int userId) const {
+        auto it = userById.find(userId);
+        return it == userById.end() ? nullptr : &Userlist[it->second];
+    }
+
+    Event* findEvent(vector<Event>& eventlist, int eventId) const {
+        auto it = eventById.find(eventId);
+        return it == eventById.end() ? nullptr : &eventlist[it->second];
+    }
+
+    const Event* findEvent(const vector<Event>& eventlist, int eventId) const {
+        auto it = eventById.find(eventId);
+        return it == eventById.end() ? nullptr : &eventlist[it->second];
+    }
+
+    Booking* findBooking(vector<Booking>& bookings, int bookingId) const {
+        auto it = bookingById.find(bookingId);
+        return it == bookingById.end() ? nullptr : &bookings[it->second];
+    }
+
+    // Positions of events dated firstDay..lastDay (inclusive), earliest first,
+    // at most limit of them
+    vector<size_t> eventsBetween(int firstDay, int lastDay, size_t limit = SIZE_MAX) const {
+        vector<size_t> found;
+        auto end = eventsByDate.upper_bound(lastDay);
+        for (auto it = eventsByDate.lower_bound(firstDay); it != end && found.size() < limit; ++it) {
+            found.push_back(it->second);
+        }
+        return found;
+    }
+
+    const vector<size_t>& userBookings(int userId) const {
+        static const vector<size_t> none;
+        auto it = bookingsByUser.find(userId);
+        return it == bookingsByUser.end() ? none : it->second;
+    }
+};
+
+// =============== SALES AGGREGATES ===============
+// Running booking totals per user, per event, per event tier and for the whole
+// system. They are adjusted in O(1) whenever a booking is made or cancelled,
+// so reports never have to re-sum the booking history. Revenue is kept in
+// cents so repeated add/subtract does not drift.
+class SalesTotals {
+public:
+    int confirmed = 0;
+    int cancelled = 0;
+    long long tickets = 0;
+    long long revenueCents = 0;
+
+    double revenue() const {
+        return revenueCents / 100.0;
+    }
+};
+
+long long toCents(float amount) {
+    return llround(amount * 100.0);
+}
+
+class SalesAggregates {
+public:
+    SalesTotals system;
+    unordered_map<int, SalesTotals> byUser;
+    unordered_map<int, SalesTotals> byEvent;
+    unordered_map<int, map<TierId, SalesTotals>> byEventTier;
+
+    void rebuild(const vector<Booking>& bookings) {
+        system = SalesTotals();
+        byUser.clear();
+        byEvent.clear();
+        byEventTier.clear();
+        for (const auto& booking : bookings) {
+            recordBooking(booking);
+        }
+    }
+
+    // Counts a booking as it currently stands (confirmed or cancelled)
+    void recordBooking(const Booking& booking) {
+        bool confirmed = booking.status == STATUS_CONFIRMED;
+        long long cents = toCents(booking.totalPrice);
+        for (SalesTotals* totals : totalsFor(booking)) {
+            if (confirmed) {
+                totals->confirmed++;
+                totals->tickets += booking.tickets;
+                totals->revenueCents += cents;
+            } else {
+                totals->cancelled++;
+            }
+        }
+    }
+
+    // Moves a previously confirmed booking over to the cancelled column
+    void recordCancel(const Booking& booking) {
+        long long cents = toCents(booking.totalPrice);
+        for (SalesTotals* totals : totalsFor(booking)) {
+            totals->confirmed--;
+            totals->cancelled++;
+            totals->tickets -= booking.tickets;
+            totals->revenueCents -= cents;
+        }
+    }
+
+    const SalesTotals& forUser(int userId) const {
+        return lookup(byUser, userId);
+    }
+
+    const SalesTotals& forEvent(int eventId) const {
+        return lookup(byEvent, eventId);
+    }
+
+private:
+    array<SalesTotals*, 4> totalsFor(const Booking& booking) {
+        return {&system, &byUser[booking.userId], &byEvent[booking.eventId],
+                &byEventTier[booking.eventId][booking.tierId]};
+    }
+
+    static const SalesTotals& lookup(const unordered_map<int, SalesTotals>& totals, int id) {
+        static const SalesTotals none;
+        auto it = totals.find(id);
+        return it == totals.end() ? none : it->second;
+    }
+};
+
+// =============== COLUMNAR BOOKING STORE ===============
+// Structure-of-arrays copy of the booking history for analytics: int32 ids,
+// tier ids, ticket counts and prices in cents, plus one confirmed bit per
+// booking. Row i corresponds to bookings[i]. The scan kernels sum the
+// confirmed rows (optionally for a single event) without touching the
+// Booking objects, using AVX2 when the CPU has it and a branchless scalar
+// loop otherwise. sumByTier() splits the sums by event and tier for the
+// sales reports.
+//
+// It is built on demand for full-history scans: each sales report builds one
+// from its snapshot. The engine does not keep one up to date: its running
+// totals (SalesAggregates) already answer every total the program shows, so
+// bookings and cancellations would only pay to maintain it.
+
+// One group's sums from ColumnarBookings::sumByTier
+class GroupTotals {
+public:
+    SalesTotals totals;  // confirmed tickets and revenue, bookings made and cancelled
+    long long cancelledTickets = 0;
+};
+
+class ColumnarBookings {
+public:
+    vector<int32_t> bookingIds;
+    vector<int32_t> userIds;
+    vector<int32_t> eventIds;
+    vector<TierId> tierIds;
+    vector<int32_t> tickets;
+    vector<int32_t> priceCents;
+    vector<uint64_t> confirmedBits;
+
+    size_t size() const {
+        return bookingIds.size();
+    }
+
+    // Bookings: a vector or a BookingSnapshot
+    template <typename Bookings>
+    void build(const Bookings& bookings) {
+        bookingIds.clear();
+        userIds.clear();
+        eventIds.clear();
+        tierIds.clear();
+        tickets.clear();
+        priceCents.clear();
+        confirmedBits.clear();
+        bookingIds.reserve(bookings.size());
+        userIds.reserve(bookings.size());
+        eventIds.reserve(bookings.size());
+        tierIds.reserve(bookings.size());
+        tickets.reserve(bookings.size());
+        priceCents.reserve(bookings.size());
+        confirmedBits.reserve(bookings.size() / 64 + 1);
+        for (const auto& booking : bookings) {
+            append(booking);
+        }
+    }
+
+    void append(const Booking& booking) {
+        size_t row = size();
+        bookingIds.push_back(booking.bookingId);
+        userIds.push_back(booking.userId);
+        eventIds.push_back(booking.eventId);
+        tierIds.push_back(booking.tierId);
+        tickets.push_back(booking.tickets);
+        priceCents.push_back((int32_t)toCents(booking.totalPrice));
+        if (row % 64 == 0) confirmedBits.push_back(0);
+        setConfirmed(row, booking.status == STATUS_CONFIRMED);
+    }
+
+    void setConfirmed(size_t row, bool confirmed) {
+        uint64_t bit = 1ull << (row % 64);
+        if (confirmed) {
+            confirmedBits[row / 64] |= bit;
+        } else {
+            confirmedBits[row / 64] &= ~bit;
+        }
+    }
+
+    bool isConfirmed(size_t row) const {
+        return (confirmedBits[row / 64] >> (row % 64)) & 1;
+    }
+
+    // Totals over the whole history
+    SalesTotals summarize() const {
+        return scan(0, true);
+    }
+
+    SalesTotals summarizeEvent(int eventId) const {
+        return scan(eventId, false);
+    }
+
+    // Adds every row into groups[firstGroup[eventId] + tierId], where the
+    // event has groupCount[eventId] groups, one per TierId. Rows of other
+    // events (no groups, or an id past the end of the tables) and tier ids
+    // past the event's groups go to groups[0], which the caller discards.
+    // The tables have at least one entry.
+    // AVX2 can gather but not scatter, so this stays a branchless scalar loop.
+    void sumByTier(const vector<int32_t>& firstGroup, const vector<int32_t>& groupCount,
+                   vector<GroupTotals>& groups) const {
+        size_t events = firstGroup.size();
+        for (size_t i = 0; i < size(); i++) {
+            size_t eventId = (uint32_t)eventIds[i];
+            bool known = eventId < events;
+            size_t at = known ? eventId : 0;
+            int32_t inRange = known & (tierIds[i] < groupCount[at]);
+            GroupTotals& group = groups[(firstGroup[at] + tierIds[i]) & -inRange];
+
+            int32_t hit = (int32_t)((confirmedBits[i / 64] >> (i % 64)) & 1);
+            group.totals.confirmed += hit;
+            group.totals.cancelled += 1 - hit;
+            group.totals.tickets += tickets[i] & -hit;
+            group.totals.revenueCents += priceCents[i] & -(long long)hit;
+            group.cancelledTickets += tickets[i] & (hit - 1);
+        }
+    }
+
+private:
+    SalesTotals scan(int eventId, bool allEvents) const {
+        #ifdef BOOKING_SCAN_AVX2
+        static const bool haveAvx2 = __builtin_cpu_supports("avx2");
+        if (haveAvx2) return scanAvx2(eventId, allEvents);
+        #endif
+        return scanScalar(eventId, allEvents, 0, SalesTotals());
+    }
+
+    // Branchless so the compiler can vectorise it where it is able to.
+    SalesTotals scanScalar(int eventId, bool allEvents, size_t start, SalesTotals totals) const {
+        long long matched = totals.confirmed + totals.cancelled;
+        long long confirmed = totals.confirmed;
+        for (size_t i = start; i < size(); i++) {
+            int32_t match = allEvents | (eventIds[i] == eventId);
+            int32_t hit = match & (int32_t)((confirmedBits[i / 64] >> (i % 64)) & 1);
+            matched += match;
+            confirmed += hit;
+            totals.tickets += tickets[i] & -hit;
+            totals.revenueCents += priceCents[i] & -(long long)hit;
+        }
+        totals.confirmed = (int)confirmed;
+        totals.cancelled = (int)(matched - confirmed);
+        return totals;
+    }
+
+    #ifdef BOOKING_SCAN_AVX2
+    // Eight rows per step: the confirmed byte for the rows is expanded into a
+    // lane mask, ANDed with the event match, and the selected tickets and
+    // prices are widened into 64-bit accumulators.
+    __attribute__((target("avx2")))
+    SalesTotals scanAvx2(int eventId, bool allEvents) const {
+        const __m256i key = _mm256_set1_epi32(eventId);
+        const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i everything = _mm256_set1_epi32(-1);
+        __m256i matchedAcc = _mm256_setzero_si256();
+        __m256i confirmedAcc = _mm256_setzero_si256();
+        __m256i ticketsAcc = _mm256_setzero_si256();
+        __m256i centsAcc = _mm256_setzero_si256();
+
+        size_t blocks = size() / 8 * 8;
+        for (size_t i = 0; i < blocks; i += 8) {
+            int byte = (int)((confirmedBits[i / 64] >> (i % 64)) & 0xFF);
+            __m256i confirmed = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), laneBits), laneBits);
+            __m256i match = allEvents ? everything
+                : _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)&eventIds[i]), key);
+            __m256i hit = _mm256_and_si256(match, confirmed);
+            matchedAcc = _mm256_sub_epi32(matchedAcc, match);
+            confirmedAcc = _mm256_sub_epi32(confirmedAcc, hit);
+
+            __m256i t = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&tickets[i]), hit);
+            __m256i c = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&priceCents[i]), hit);
+            ticketsAcc = _mm256_add_epi64(ticketsAcc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(t)));
+            ticketsAcc = _mm256_add_epi64(ticketsAcc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(t, 1)));
+            centsAcc = _mm256_add_epi64(centsAcc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(c)));
+            centsAcc = _mm256_add_epi64(centsAcc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(c, 1)));
+        }
+
+        alignas(32) int32_t lanes32[8];
+        alignas(32) long long lanes64[4];
+        SalesTotals totals;
+        long long matched = 0;
+        _mm256_store_si256((__m256i*)lanes32, matchedAcc);
+        for (int32_t lane : lanes32) matched += lane;
+        _mm256_store_si256((__m256i*)lanes32, confirmedAcc);
+        for (int32_t lane : lanes32) totals.confirmed += lane;
+        totals.cancelled = (int)(matched - totals.confirmed);
+        _mm256_store_si256((__m256i*)lanes64, ticketsAcc);
+        for (long long lane : lanes64) totals.tickets += lane;
+        _mm256_store_si256((__m256i*)lanes64, centsAcc);
+        for (long long lane : lanes64) totals.revenueCents += lane;
+
+        return scanScalar(eventId, allEvents, blocks, totals);
+    }
+    #endif
+};
+
+// =============== BOOKING SNAPSHOTS ===============
+// Long reads (sales reports, the booking views, journal compaction) work on a
+// BookingSnapshot: every booking as it stood at one moment, unchanged however
+// much booking and cancelling goes on while it is read.
+//
+// BookingPages keeps a second copy of the bookings, in the same order as the
+// bookings vector, in pages that never move once allocated. A snapshot is the
+// list of pages plus the booking count when it was taken, so taking one costs
+// a pointer per page rather than a copy of every row, and writers never wait
+// for a reader. New bookings go in past the end of every snapshot. A
+// cancellation changes a row a snapshot may be reading, so a page still held
+// by a snapshot is copied first and the snapshot keeps the old page.
+class BookingPage {
+public:
+    static constexpr size_t ROWS = 4096;
+    vector<Booking> rows;  // reserved to ROWS up front, so rows never move
+
+    BookingPage() {
+        rows.reserve(ROWS);
+    }
+
+    BookingPage(const BookingPage& other) {
+        rows.reserve(ROWS);
+        rows.insert(rows.end(), other.rows.begin(), other.rows.end());
+    }
+};
+
+class BookingSnapshot {
+public:
+    class iterator {
+    public:
+        iterator(const BookingSnapshot& snapshot, size_t pos) : owner(&snapshot), row(pos) {}
+        const Booking& operator*() const { return (*owner)[row]; }
+        iterator& operator++() { row++; return *this; }
+        bool operator!=(const iterator& other) const { return row != other.row; }
+
+    private:
+        const BookingSnapshot* owner;
+        size_t row;
+    };
+
+    // Positions match the bookings vector (and so DataIndex) at the time
+    const Booking& operator[](size_t pos) const {
+        return pages[pos / BookingPage::ROWS]->rows[pos % BookingPage::ROWS];
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    iterator begin() const {
+        return iterator(*this, 0);
+    }
+
+    iterator end() const {
+        return iterator(*this, count);
+    }
+
+    // The sales totals for exactly these rows. Shared with the engine until
+    // its next change, which copies them first.
+    shared_ptr<const SalesAggregates> totals;
+    // The reported events' unsold tickets tier by tier, as they stood with
+    // the rows. Only filled in by BookingEngine::reportSnapshot.
+    unordered_map<int, vector<int>> unsold;  // by event id, in tier order
+    // One user's rows, oldest first. Only filled in by
+    // BookingEngine::userSnapshot.
+    vector<size_t> userRows;
+
+private:
+    friend class BookingPages;
+    vector<shared_ptr<const BookingPage>> pages;
+    size_t count = 0;
+};
+
+// Changed alongside the bookings vector, under the same lock
+class BookingPages {
+public:
+    void build(const vector<Booking>& bookings) {
+        pages.clear();
+        count = 0;
+        for (const auto& booking : bookings) append(booking);
+    }
+
+    void append(const Booking& booking) {
+        if (count % BookingPage::ROWS == 0) pages.push_back(make_shared<BookingPage>());
+        pages.back()->rows.push_back(booking);
+        count++;
+    }
+
+    void setStatus(size_t row, BookingStatus status) {
+        shared_ptr<BookingPage>& page = pages[row / BookingPage::ROWS];
+        if (page.use_count() > 1) page = make_shared<BookingPage>(*page);
+        page->rows[row % BookingPage::ROWS].status = status;
+    }
+
+    BookingSnapshot snapshot() const {
+        BookingSnapshot taken;
+        taken.pages.assign(pages.begin(), pages.end());
+        taken.count = count;
+        return taken;
+    }
+
+private:
+    vector<shared_ptr<BookingPage>> pages;
+    size_t count = 0;
+};
+
+// =============== SALES REPORTS ===============
+// Per-event and per-tier sales figures for finance: tickets sold and still
+// unsold, revenue, and cancellations. They are gathered in one pass over the
+// booking history for the chosen events (one event, a date range or all of
+// them), grouped by tier over a ColumnarBookings copy of the snapshot. Reports are written as CSV or JSON through ReportWriter, which
+// fills a large buffer and only hands it to the file when it is full, so
+// nothing is flushed row by row.
+// Buffered text output for reports. Everything goes into a 1 MB buffer that
+// is written to the file in one call when it fills up and on close, instead
+// of through the stream a row (or a field) at a time.
+class ReportWriter {
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    ReportWriter(const string& filename) : out(filename, ios::binary), buffer(new char[BUFFER_SIZE]) {}
+
+    ~ReportWriter() {
+        close();
+    }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    void text(string_view s) {
+        if (s.size() > BUFFER_SIZE - used) {
+            drain();
+            if (s.size() > BUFFER_SIZE) {
+                out.write(s.data(), s.size());
+                return;
+            }
+        }
+        memcpy(buffer.get() + used, s.data(), s.size());
+        used += s.size();
+    }
+
+    void number(long long value) {
+        char digits[24];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        text(string_view(digits, result.ptr - digits));
+    }
+
+    // Cents as dollars with two decimals
+    void money(long long cents) {
+        if (cents < 0) {
+            text("-");
+            cents = -cents;
+        }
+        number(cents / 100);
+        char fraction[3] = {'.', (char)('0' + cents % 100 / 10), (char)('0' + cents % 10)};
+        text(string_view(fraction, 3));
+    }
+
+    void decimal(double value, int places) {
+        char digits[32];
+        auto result = to_chars(digits, digits + sizeof(digits), value, chars_format::fixed, places);
+        text(string_view(digits, result.ptr - digits));
+    }
+
+    // Quoted only when it has to be
+    void csvField(string_view s) {
+        if (s.find_first_of(",\"\r\n") == string_view::npos) {
+            text(s);
+            return;
+        }
+        text("\"");
+        size_t start = 0;
+        for (size_t quote = s.find('"'); quote != string_view::npos; quote = s.find('"', start)) {
+            text(s.substr(start, quote + 1 - start));
+            text("\"");
+            start = quote + 1;
+        }
+        text(s.substr(start));
+        text("\"");
+    }
+
+    void jsonString(string_view s) {
+        text("\"");
+        size_t start = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            unsigned char c = s[i];
+            if (c != '"' && c != '\\' && c >= 0x20) continue;
+            text(s.substr(start, i - start));
+            char escape[7];
+            snprintf(escape, sizeof(escape), c == '"' || c == '\\' ? "\\%c" : "\\u%04x", c);
+            text(escape);
+            start = i + 1;
+        }
+        text(s.substr(start));
+        text("\"");
+    }
+
+    // Writes out what is buffered and closes the file. False if anything
+    // could not be written.
+    bool close() {
+        if (out.is_open()) {
+            drain();
+            out.close();
+        }
+        return !out.fail();
+    }
+
+private:
+    ofstream out;
+    unique_ptr<char[]> buffer;
+    size_t used = 0;
+
+    void drain() {
+        out.write(buffer.get(), used);
+        used = 0;
+    }
+};
+
+class TierSales {
+public:
+    TierId tierId = 0;
+    float price = 0;
+    int remaining = 0;       // unsold, including tickets in holds
+    SalesTotals totals;      // bookings, tickets sold and revenue
+    long long cancelledTickets = 0;
+
+    // Share of this tier's bookings that were cancelled
+    double cancellationRate() const {
+        int made = totals.confirmed + totals.cancelled;
+        return made ? (double)totals.cancelled / made : 0;
+    }
+};
+
+class EventSales {
+public:
+    const Event* event = nullptr;
+    vector<TierSales> tiers;  // the event's tiers, then tiers only its bookings name
+    TierSales overall;        // all tiers together (tierId and price unused)
+};
+
+class SalesReport {
+public:
+    vector<EventSales> events;
+    TierSales overall;
+
+    // eventPositions are eventlist positions, in the order to report them
+    void build(const vector<Event>& eventlist, const vector<size_t>& eventPositions,
+               const BookingSnapshot& bookings) {
+        events.clear();
+        events.reserve(eventPositions.size());
+        unordered_map<int, size_t> slotOf;
+        slotOf.reserve(eventPositions.size());
+        for (size_t pos : eventPositions) {
+            const Event& event = eventlist[pos];
+            if (!slotOf.emplace(event.eventID, events.size()).second) continue;
+            EventSales& sales = events.emplace_back();
+            sales.event = &event;
+            // Counted with the bookings, unless the event is newer than they are
+            auto counted = bookings.unsold.find(event.eventID);
+            for (const auto& tier : event.ticketTiers) {
+                size_t t = sales.tiers.size();
+                TierSales& tierSales = sales.tiers.emplace_back();
+                tierSales.tierId = tier.nameId;
+                tierSales.price = tier.price;
+                tierSales.remaining = counted != bookings.unsold.end() && t < counted->second.size()
+                                          ? counted->second[t] : tier.unsold();
+            }
+        }
+
+        int maxEventId = 0;
+        bool denseIds = true;
+        for (const auto& sales : events) {
+            maxEventId = max(maxEventId, sales.event->eventID);
+            denseIds = denseIds && sales.event->eventID >= 0;
+        }
+        if (denseIds && maxEventId < MAX_DENSE_EVENT_ID) {
+            sumColumns(bookings, maxEventId);
+        } else {
+            sumRows(bookings, slotOf);
+        }
+
+        overall = TierSales();
+        for (auto& sales : events) {
+            for (const auto& tier : sales.tiers) add(sales.overall, tier);
+            add(overall, sales.overall);
+        }
+    }
+
+    size_t tierCount() const {
+        size_t count = 0;
+        for (const auto& sales : events) count += sales.tiers.size();
+        return count;
+    }
+
+    // One row per tier, followed by an ALL row with the event's totals
+    void writeCsv(ReportWriter& out) const {
+        out.text("event_id,event_name,event_date,location,tier,price,sold,remaining,revenue,"
+                 "confirmed_bookings,cancelled_bookings,cancelled_tickets,cancellation_rate\n");
+        for (const auto& sales : events) {
+            for (const auto& tier : sales.tiers) {
+                csvRow(sales, sales.event->tierName(tier.tierId), &tier.price, tier, out);
+            }
+            csvRow(sales, "ALL", nullptr, sales.overall, out);
+        }
+    }
+
+    void writeJson(ReportWriter& out) const {
+        out.text("{\"events\":[");
+        for (size_t i = 0; i < events.size(); i++) {
+            const EventSales& sales = events[i];
+            if (i) out.text(",");
+            out.text("\n{\"id\":");
+            out.number(sales.event->eventID);
+            out.text(",\"name\":");
+            out.jsonString(sales.event->eventName);
+            out.text(",\"date\":");
+            out.jsonString(sales.event->eventDate);
+            out.text(",\"location\":");
+            out.jsonString(sales.event->eventLocation);
+            out.text(",");
+            jsonFigures(sales.overall, out);
+            out.text(",\"tiers\":[");
+            for (size_t t = 0; t < sales.tiers.size(); t++) {
+                const TierSales& tier = sales.tiers[t];
+                if (t) out.text(",");
+                out.text("{\"tier\":");
+                out.jsonString(sales.event->tierName(tier.tierId));
+                out.text(",\"price\":");
+                out.money(toCents(tier.price));
+                out.text(",");
+                jsonFigures(tier, out);
+                out.text("}");
+            }
+            out.text("]}");
+        }
+        out.text("\n],\"totals\":{");
+        jsonFigures(overall, out);
+        out.text("}}\n");
+    }
+
+private:
+    // Event ids come from getNextEventID, so the tables sumByTier indexes by
+    // id stay small. Only a hand-edited events.txt goes past this, and its
+    // reports are summed row by row.
+    static const int MAX_DENSE_EVENT_ID = 1 << 20;
+
+    void sumColumns(const BookingSnapshot& bookings, int maxEventId) {
+        vector<int32_t> firstGroup(maxEventId + 1, 0);
+        vector<int32_t> groupCount(maxEventId + 1, 0);
+        int32_t groupTotal = 1;  // group 0 collects the rows of other events
+        for (const auto& sales : events) {
+            int eventId = sales.event->eventID;
+            firstGroup[eventId] = groupTotal;
+            groupCount[eventId] = (int32_t)sales.event->tierNames.size();
+            groupTotal += groupCount[eventId];
+        }
+
+        ColumnarBookings columns;
+        columns.build(bookings);
+        vector<GroupTotals> groups(groupTotal);
+        columns.sumByTier(firstGroup, groupCount, groups);
+
+        for (auto& sales : events) {
+            int eventId = sales.event->eventID;
+            for (int32_t t = 0; t < groupCount[eventId]; t++) {
+                const GroupTotals& group = groups[firstGroup[eventId] + t];
+                auto tier = find_if(sales.tiers.begin(), sales.tiers.end(),
+                                    [&](const TierSales& sold) { return sold.tierId == t; });
+                if (tier == sales.tiers.end()) {
+                    // A name in the event's table that none of its tiers has
+                    if (group.totals.confirmed + group.totals.cancelled == 0) continue;
+                    tier = sales.tiers.emplace(sales.tiers.end());
+                    tier->tierId = (TierId)t;
+                }
+                tier->totals = group.totals;
+                tier->cancelledTickets = group.cancelledTickets;
+            }
+        }
+    }
+
+    void sumRows(const BookingSnapshot& bookings, const unordered_map<int, size_t>& slotOf) {
+        for (const auto& booking : bookings) {
+            auto slot = slotOf.find(booking.eventId);
+            if (slot == slotOf.end()) continue;
+            vector<TierSales>& tiers = events[slot->second].tiers;
+            auto tier = find_if(tiers.begin(), tiers.end(),
+                                [&](const TierSales& t) { return t.tierId == booking.tierId; });
+            if (tier == tiers.end()) {
+                tier = tiers.emplace(tiers.end());
+                tier->tierId = booking.tierId;
+            }
+            count(*tier, booking);
+        }
+    }
+
+    static void count(TierSales& tier, const Booking& booking) {
+        if (booking.status == STATUS_CONFIRMED) {
+            tier.totals.confirmed++;
+            tier.totals.tickets += booking.tickets;
+            tier.totals.revenueCents += toCents(booking.totalPrice);
+        } else {
+            tier.totals.cancelled++;
+            tier.cancelledTickets += booking.tickets;
+        }
+    }
+
+    static void add(TierSales& sum, const TierSales& tier) {
+        sum.remaining += tier.remaining;
+        sum.totals.confirmed += tier.totals.confirmed;
+        sum.totals.cancelled += tier.totals.cancelled;
+        sum.totals.tickets += tier.totals.tickets;
+        sum.totals.revenueCents += tier.totals.revenueCents;
+        sum.cancelledTickets += tier.cancelledTickets;
+    }
+
+    static void csvRow(const EventSales& sales, string_view tierName, const float* price,
+                       const TierSales& figures, ReportWriter& out) {
+        const Event& event = *sales.event;
+        out.number(event.eventID);
+        out.text(",");
+        out.csvField(event.eventName);
+        out.text(",");
+        out.csvField(event.eventDate);
+        out.text(",");
+        out.csvField(event.eventLocation);
+        out.text(",");
+        out.csvField(tierName);
+        out.text(",");
+        if (price) out.money(toCents(*price));
+        out.text(",");
+        out.number(figures.totals.tickets);
+        out.text(",");
+        out.number(figures.remaining);
+        out.text(",");
+        out.money(figures.totals.revenueCents);
+        out.text(",");
+        out.number(figures.totals.confirmed);
+        out.text(",");
+        out.number(figures.totals.cancelled);
+        out.text(",");
+        out.number(figures.cancelledTickets);
+        out.text(",");
+        out.decimal(figures.cancellationRate(), 4);
+        out.text("\n");
+    }
+
+    static void jsonFigures(const TierSales& figures, ReportWriter& out) {
+        out.text("\"sold\":");
+        out.number(figures.totals.tickets);
+        out.text(",\"remaining\":");
+        out.number(figures.remaining);
+        out.text(",\"revenue\":");
+        out.money(figures.totals.revenueCents);
+        out.text(",\"confirmed_bookings\":");
+        out.number(figures.totals.confirmed);
+        out.text(",\"cancelled_bookings\":");
+        out.number(figures.totals.cancelled);
+        out.text(",\"cancelled_tickets\":");
+        out.number(figures.cancelledTickets);
+        out.text(",\"cancellation_rate\":");
+        out.decimal(figures.cancellationRate(), 4);
+    }
+};
+
+// Where the sales-report command puts its files
+const string REPORTS_DIRECTORY = "reports";
+
+// Writes the report to filename as JSON or CSV. False if the file could not
+// be written.
+bool exportSalesReport(const SalesReport& report, const string& filename, bool json) {
+    ReportWriter out(filename);
+    if (json) {
+        report.writeJson(out);
+    } else {
+        report.writeCsv(out);
+    }
+    return out.close();
+}
+
+// =============== BOOKING JOURNAL ===============
+// Bookings and cancellations are appended to bookings.journal (one line each)
+// instead of rewriting events.txt and bookings.txt on every ticket sold.
+// At startup the journal is replayed on top of the .txt snapshot; once it grows
+// past compactThreshold bytes it is folded back into the snapshot on a
+// background thread.
+//
+// A record is on disk before the booking it records is acknowledged. Each
+// append is one write() to the file; the caller then waits in waitDurable(),
+// outside bookingsMutex, for a data sync. Syncs are group commits: one
+// thread syncs at a time, and the records appended while it does are covered
+// together by the next one, so a busy server pays for one sync per batch
+// rather than per booking. Snapshots sync the .txt files and their renames
+// before the journal is emptied.
+//
+// Record format:
+//   B,bookingId,userId,eventId,tickets,totalPrice,ticketTier[,seatId]
+//   C,bookingId
+//   U,userId,name  (only written in shared mode, see SHARED INVENTORY)
+class JournalRecord {
+public:
+    char kind = 0;  // 'B', 'C' or 'U'
+    Booking booking{0, 0, 0, 0, 0, 0};  // B; only bookingId is set for C
+    string tierName;  // B; booking.tierId is left for the reader to look up
+    User user{0, ""};  // U
+
+    // Looks the booking's tier up in its event, as the journal only names it
+    bool resolveTier(TierScope& tiers) {
+        return tiers.intern(booking.eventId, tierName, booking.tierId);
+    }
+};
+
+class BookingJournal {
+public:
+    string path;
+    streamoff compactThreshold;
+    thread compactor;
+    #ifdef BOOKING_SHARED
+    ProcessMutex* appendLock = nullptr;  // set when several processes append
+    #endif
+
+    BookingJournal(const string& file = "bookings.journal", streamoff threshold = 1 << 20) {
+        path = file;
+        compactThreshold = threshold;
+    }
+
+    ~BookingJournal() {
+        waitForCompaction();
+        close();
+    }
+
+    BookingJournal(const BookingJournal&) = delete;
+    BookingJournal& operator=(const BookingJournal&) = delete;
+
+    void open() {
+        #ifdef _WIN32
+        fd = _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+        #else
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        #endif
+        if (fd < 0) {
+            cerr << "Error opening booking journal\n";
+            return;
+        }
+        error_code ignored;
+        auto existing = filesystem::file_size(path, ignored);
+        size = ignored ? 0 : (streamoff)existing;
+    }
+
+    // The append functions return the record's number for waitDurable()
+    uint64_t appendBooking(const Booking& booking, const string& tierName) {
+        ostringstream line;
+        line << "B," << booking.bookingId << ","
+             << booking.userId << ","
+             << booking.eventId << ","
+             << booking.tickets << ","
+             << fixed << setprecision(2) << booking.totalPrice << ","
+             << tierName;
+        if (booking.seatId >= 0) line << "," << booking.seatId;
+        line << "\n";
+        return append(line.str());
+    }
+
+    uint64_t appendCancel(int bookingId) {
+        return append("C," + to_string(bookingId) + "\n");
+    }
+
+    uint64_t appendUser(const User& user) {
+        return append("U," + to_string(user.UserId) + "," + user.UserName + "\n");
+    }
+
+    // Returns once record, and every record appended before it, is on disk.
+    // Not under bookingsMutex, so others can append while this thread waits.
+    void waitDurable(uint64_t record) {
+        lock_guard<mutex> lock(syncMutex);
+        if (synced >= record) return;  // covered by the sync we waited behind
+        uint64_t through = appended.load();
+        if (fd >= 0 && !syncData(fd)) {
+            cerr << "Error syncing booking journal\n";
+        }
+        synced = through;
+    }
+
+    // Applies the journal (and a journal left behind by an interrupted
+    // compaction) to the loaded snapshot. Records already present in the
+    // snapshot are skipped, so replaying the same journal twice is harmless.
+    void replay(vector<User>& Userlist, vector<Event>& eventlist, vector<Booking>& bookings, DataIndex& index) {
+        bool interrupted = replayFile(path + ".compacting", Userlist, eventlist, bookings, index);
+        replayFile(path, Userlist, eventlist, bookings, index);
+        if (interrupted) {
+            checkpoint(eventlist, bookings);
+        }
+    }
+
+    // Calls apply(record) for each complete record from offset on and moves
+    // offset past them. A last line without its newline is still being
+    // written and is left for next time.
+    template <typename Apply>
+    void readFrom(streamoff& offset, Apply apply) const {
+        ifstream inFile(path, ios::binary);
+        if (!inFile || !inFile.seekg(offset)) return;
+
+        string line;
+        JournalRecord record;
+        while (getline(inFile, line) && !inFile.eof()) {
+            offset += line.size() + 1;
+            if (parseRecord(line, record)) apply(record);
+        }
+    }
+
+    bool full() {
+        return size >= compactThreshold;
+    }
+
+    // Starts a background compaction once the journal has grown large enough.
+    void compactIfNeeded(const vector<User>& Userlist, const vector<Event>& eventlist,
+                         const BookingSnapshot& bookings) {
+        if (size < compactThreshold) return;
+
+        waitForCompaction();
+        close();
+        rename(path.c_str(), (path + ".compacting").c_str());
+        open();
+
+        // The compactor works on its own copy of the users and events and a
+        // snapshot of the bookings, so booking can carry on while the files
+        // are written. It writes data.snapshot after the .txt files, so the
+        // next startup can load it. users.txt is stamped now: it is not the
+        // compactor's to write, and may be rewritten while it runs.
+        vector<User> userCopy = Userlist;
+        vector<Event> eventCopy = eventlist;
+        SourceStamp usersStamp = stampFile(SNAPSHOT_SOURCES[0]);
+        string journalPath = path;
+        compactor = thread([userCopy = move(userCopy), eventCopy = move(eventCopy), bookings,
+                            usersStamp, journalPath]() {
+            writeSnapshot(eventCopy, bookings);
+            writeSnapshotFile(userCopy, eventCopy, bookings, "data.snapshot", &usersStamp);
+            remove((journalPath + ".compacting").c_str());
+        });
+    }
+
+    // Writes the snapshot synchronously and empties the journal. Used whenever
+    // events.txt has to be rewritten anyway (new event, exit).
+    void checkpoint(const vector<Event>& eventlist, const vector<Booking>& bookings) {
+        waitForCompaction();
+        writeSnapshot(eventlist, bookings);
+        close();
+        error_code ignored;  // no journal yet; open() creates it
+        filesystem::resize_file(path, 0, ignored);
+        open();
+        remove((path + ".compacting").c_str());
+    }
+
+    void waitForCompaction() {
+        if (compactor.joinable()) {
+            compactor.join();
+        }
+    }
+
+    // Both .tmp files are complete before either is renamed, so a lone
+    // events.txt.tmp means a snapshot stopped between the two renames:
+    // bookings.txt is new and events.txt still has the counts from before.
+    // Finishing the rename keeps the counts in step with the bookings they
+    // were saved with. Anything else left over was never renamed and is
+    // dropped. Before the data files are loaded.
+    static void finishSnapshot() {
+        if (filesystem::exists("events.txt.tmp") && !filesystem::exists("bookings.txt.tmp")) {
+            rename("events.txt.tmp", "events.txt");
+        }
+        remove("bookings.txt.tmp");
+        remove("events.txt.tmp");
+    }
+
+private:
+    template <typename Bookings>
+    static void writeSnapshot(const vector<Event>& eventlist, const Bookings& bookings) {
+        saveBookings(bookings, eventlist, "bookings.txt.tmp");
+        saveEvents(eventlist, "events.txt.tmp");
+        syncFile("bookings.txt.tmp");
+        syncFile("events.txt.tmp");
+        rename("bookings.txt.tmp", "bookings.txt");
+        rename("events.txt.tmp", "events.txt");
+        syncFile(".");
+    }
+
+    int fd = -1;
+    streamoff size = 0;            // bytes this process has seen in the journal
+    atomic<uint64_t> appended{0};  // records written to fd so far
+    mutex syncMutex;
+    uint64_t synced = 0;           // records known to be on disk; under syncMutex
+
+    // Under bookingsMutex, like every append
+    uint64_t append(const string& line) {
+        AppendGuard guard(*this);
+        const char* data = line.data();
+        size_t left = line.size();
+        while (left > 0 && fd >= 0) {
+            #ifdef _WIN32
+            int written = _write(fd, data, (unsigned)left);
+            #else
+            ssize_t written = ::write(fd, data, left);
+            if (written < 0 && errno == EINTR) continue;
+            #endif
+            if (written <= 0) {
+                cerr << "Error writing booking journal\n";
+                break;
+            }
+            data += written;
+            left -= written;
+        }
+        size += line.size();
+        return ++appended;
+    }
+
+    // Syncs what has been appended and closes the file, so waiters on
+    // records written to it are not left waiting on a closed descriptor
+    void close() {
+        lock_guard<mutex> lock(syncMutex);
+        if (fd < 0) return;
+        if (synced < appended.load() && !syncData(fd)) {
+            cerr << "Error syncing booking journal\n";
+        }
+        synced = appended.load();
+        #ifdef _WIN32
+        _close(fd);
+        #else
+        ::close(fd);
+        #endif
+        fd = -1;
+    }
+
+    static bool syncData(int fileDescriptor) {
+        #if defined(_WIN32)
+        return _commit(fileDescriptor) == 0;
+        #elif defined(__linux__)
+        return fdatasync(fileDescriptor) == 0;
+        #else
+        return fsync(fileDescriptor) == 0;
+        #endif
+    }
+
+    // Serialises appends from several processes so their lines never mix
+    class AppendGuard {
+    public:
+        AppendGuard(BookingJournal& bookingJournal) {
+            #ifdef BOOKING_SHARED
+            lock = bookingJournal.appendLock;
+            if (lock) lock->lock();
+            #endif
+        }
+
+        ~AppendGuard() {
+            #ifdef BOOKING_SHARED
+            if (lock) lock->unlock();
+            #endif
+        }
+
+    private:
+        #ifdef BOOKING_SHARED
+        ProcessMutex* lock;
+        #endif
+    };
+
+    static bool parseRecord(const string& line, JournalRecord& record) {
+        if (line.size() < 3 || line[1] != ',') return false;
+
+        vector<string> tokens;
+        size_t start = 2;
+        size_t end = line.find(',', start);
+        while (end != string::npos) {
+            tokens.push_back(line.substr(start, end - start));
+            start = end + 1;
+            end = line.find(',', start);
+        }
+        tokens.push_back(line.substr(start));
+
+        try {
+            record.kind = line[0];
+            if (line[0] == 'B' && (tokens.size() == 6 || tokens.size() == 7)) {
+                int seatId = tokens.size() == 7 ? stoi(tokens[6]) : -1;
+                record.booking = Booking(stoi(tokens[0]), stoi(tokens[1]), stoi(tokens[2]),
+                                         stoi(tokens[3]), stof(tokens[4]), 0, seatId);
+                record.tierName = move(tokens[5]);
+                return true;
+            }
+            if (line[0] == 'C' && tokens.size() == 1) {
+                record.booking.bookingId = stoi(tokens[0]);
+                return true;
+            }
+            if (line[0] == 'U' && tokens.size() >= 2) {
+                // The name may itself contain commas
+                size_t nameStart = line.find(',', 2) + 1;
+                record.user = User(stoi(tokens[0]), line.substr(nameStart));
+                return true;
+            }
+        } catch (...) {
+        }
+        return false;
+    }
+
+    static bool replayFile(const string& filename, vector<User>& Userlist, vector<Event>& eventlist,
+                           vector<Booking>& bookings, DataIndex& index) {
+        ifstream inFile(filename);
+        if (!inFile) return false;
+
+        string line;
+        JournalRecord record;
+        TierScope tiers(eventlist);
+        while (getline(inFile, line)) {
+            if (!parseRecord(line, record)) continue;
+
+            if (record.kind == 'B') {
+                if (index.bookingById.count(record.booking.bookingId) || !record.resolveTier(tiers)) continue;
+
+                bookings.push_back(record.booking);
+                index.addBooking(bookings, bookings.size() - 1);
+                Event* event = index.findEvent(eventlist, record.booking.eventId);
+                if (TicketTier* tier = event ? event->findTier(record.booking.tierId) : nullptr) {
+                    tier->take(record.booking.tickets);
+                }
+            } else if (record.kind == 'C') {
+                Booking* booking = index.findBooking(bookings, record.booking.bookingId);
+                if (booking && booking->status == STATUS_CONFIRMED) {
+                    booking->status = STATUS_CANCELLED;
+                    Event* event = index.findEvent(eventlist, booking->eventId);
+                    if (TicketTier* tier = event ? event->findTier(booking->tierId) : nullptr) {
+                        tier->release(booking->tickets);
+                    }
+                }
+            } else if (record.kind == 'U') {
+                if (index.findUser(Userlist, record.user.UserId)) continue;
+
+                Userlist.push_back(record.user);
+                index.addUser(Userlist, Userlist.size() - 1);
+            }
+        }
+        return true;
+    }
+};
+
+// =============== SEAT HOLDS ===============
+// A hold takes tickets out of a tier for a limited time while the buyer
+// confirms. Confirming turns it into a booking; if the buyer walks away the
+// hold expires and the tickets go back on sale.
+//
+// Expiry uses a hashed timer wheel: SLOTS buckets of TICK_MS each. A hold is
+// filed under the bucket of its expiry tick, and advancing the wheel only
+// visits the buckets for the ticks that have passed, so outstanding holds
+// cost nothing until their bucket comes round. Holds longer than one
+// revolution simply stay in their bucket for another lap. Confirmed and
+// released holds are dropped from the table at once and their bucket
+// entries are discarded when the bucket is next visited.
+const int DEFAULT_HOLD_SECONDS = 300;
+const int MAX_HOLD_SECONDS = 24 * 60 * 60;
+
+class SeatHold {
+public:
+    int holdId = 0;
+    int userId = 0;
+    int eventId = 0;
+    TierId tierId = 0;
+    int quantity = 0;
+    float totalPrice = 0;
+    int seatId = -1;  // first held seat for assigned seating
+    int64_t expiryTick = 0;
+};
+
+class HoldWheel {
+public:
+    static const int64_t TICK_MS = 100;
+    static const size_t SLOTS = 4096;  // about 7 minutes per revolution
+
+    HoldWheel() : slots(SLOTS), currentTick(nowTick()) {}
+
+    // Files the hold, assigns its id and returns it
+    int add(SeatHold hold, int holdSeconds) {
+        lock_guard<mutex> guard(lock);
+        hold.holdId = nextHoldId++;
+        hold.expiryTick = nowTick() + max<int64_t>(1, (int64_t)holdSeconds * 1000 / TICK_MS);
+        slots[hold.expiryTick % SLOTS].push_back(hold.holdId);
+        holds.emplace(hold.holdId, hold);
+        return hold.holdId;
+    }
+
+    // Removes an outstanding hold so it can be confirmed or released.
+    // False if there is no such hold or it has already expired.
+    bool take(int holdId, SeatHold& hold) {
+        lock_guard<mutex> guard(lock);
+        auto it = holds.find(holdId);
+        if (it == holds.end() || it->second.expiryTick <= nowTick()) return false;
+        hold = it->second;
+        holds.erase(it);
+        return true;
+    }
+
+    // Advances the wheel to now and hands back the holds that have expired
+    void expire(vector<SeatHold>& expired) {
+        lock_guard<mutex> guard(lock);
+        int64_t now = nowTick();
+        if (now <= currentTick) return;
+
+        // After a long idle spell each bucket only needs one visit
+        int64_t first = max(currentTick + 1, now - (int64_t)SLOTS + 1);
+        for (int64_t tick = first; tick <= now; tick++) {
+            vector<int>& slot = slots[tick % SLOTS];
+            size_t kept = 0;
+            for (int holdId : slot) {
+                auto it = holds.find(holdId);
+                if (it == holds.end()) continue;  // confirmed or released
+                if (it->second.expiryTick > now) {
+                    slot[kept++] = holdId;  // due on a later lap
+                    continue;
+                }
+                expired.push_back(it->second);
+                holds.erase(it);
+            }
+            slot.resize(kept);
+        }
+        currentTick = now;
+    }
+
+    size_t outstanding() {
+        lock_guard<mutex> guard(lock);
+        return holds.size();
+    }
+
+private:
+    mutex lock;
+    vector<vector<int>> slots;
+    unordered_map<int, SeatHold> holds;
+    int64_t currentTick;
+    int nextHoldId = 1;
+
+    static int64_t nowTick() {
+        return chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count() / TICK_MS;
+    }
+};
+
+// =============== WAITLIST ===============
+// Customers can queue for a tier that has sold out. When tickets come back
+// (a cancellation or an expired hold) BookingEngine books them for the
+// customers at the front of the queue straight away, oldest first.
+//
+// Each tier's queue is a linked list that any number of threads join with a
+// single atomic exchange and no lock. Only promotion reads and pops it, under
+// the queue's consumer mutex. The front node is a spent placeholder, so a
+// join never touches a node promotion may free. A joiner whose node is not
+// linked in yet is simply not seen until the next promotion.
+class Waiter {
+public:
+    int userId = 0;
+    int quantity = 0;
+};
+
+// One line of waitlist.txt
+class WaitlistRecord {
+public:
+    int eventId = 0;
+    int userId = 0;
+    TierId tierId = 0;
+    int quantity = 0;
+};
+
+// waitlist.txt: eventId,userId,tier,quantity. Tiers no event has are dropped.
+template <>
+class RecordFormat<WaitlistRecord> : public Columns<
+    Field<&WaitlistRecord::eventId>,
+    Field<&WaitlistRecord::userId>,
+    TierField<&WaitlistRecord::tierId, false>,
+    Field<&WaitlistRecord::quantity>> {};
+
+class WaitQueue {
+public:
+    mutex consumer;  // held by whoever reads or pops the queue
+
+    WaitQueue() : back(new Node()), waiting(0) {
+        front = back.load();
+    }
+
+    ~WaitQueue() {
+        while (front) {
+            Node* next = front->next.load(memory_order_relaxed);
+            delete front;
+            front = next;
+        }
+    }
+
+    WaitQueue(const WaitQueue&) = delete;
+    WaitQueue& operator=(const WaitQueue&) = delete;
+
+    // Returns the joiner's place in the queue (1 = next to be served)
+    int push(const Waiter& waiter) {
+        Node* node = new Node();
+        node->waiter = waiter;
+        Node* previous = back.exchange(node, memory_order_acq_rel);
+        previous->next.store(node, memory_order_release);
+        return waiting.fetch_add(1, memory_order_relaxed) + 1;
+    }
+
+    // The rest need the consumer mutex
+    const Waiter* peek() const {
+        Node* next = front->next.load(memory_order_acquire);
+        return next ? &next->waiter : nullptr;
+    }
+
+    void pop() {
+        Node* next = front->next.load(memory_order_acquire);
+        delete front;
+        front = next;
+        waiting.fetch_sub(1, memory_order_relaxed);
+    }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (Node* node = front->next.load(memory_order_acquire); node;
+             node = node->next.load(memory_order_acquire)) {
+            visit(node->waiter);
+        }
+    }
+
+    int size() const {
+        return waiting.load(memory_order_relaxed);
+    }
+
+private:
+    struct Node {
+        atomic<Node*> next{nullptr};
+        Waiter waiter;
+    };
+
+    atomic<Node*> back;  // joiners append here
+    Node* front;         // placeholder before the oldest waiter
+    atomic<int> waiting;
+};
+
+// The queues of all tiers, created on first join. Cancellations check
+// queueCount first so they pay nothing while nobody is waiting anywhere.
+class Waitlists {
+public:
+    WaitQueue* find(int eventId, TierId tierId) {
+        if (queueCount.load(memory_order_acquire) == 0) return nullptr;
+        shared_lock<shared_mutex> guard(lock);
+        auto it = queues.find(key(eventId, tierId));
+        return it == queues.end() ? nullptr : it->second.get();
+    }
+
+    WaitQueue& obtain(int eventId, TierId tierId) {
+        if (WaitQueue* queue = find(eventId, tierId)) return *queue;
+        unique_lock<shared_mutex> guard(lock);
+        unique_ptr<WaitQueue>& queue = queues[key(eventId, tierId)];
+        if (!queue) {
+            queue = make_unique<WaitQueue>();
+            queueCount.fetch_add(1, memory_order_release);
+        }
+        return *queue;
+    }
+
+    // Only while nobody is joining or being promoted
+    void clear() {
+        unique_lock<shared_mutex> guard(lock);
+        queues.clear();
+        queueCount.store(0, memory_order_release);
+    }
+
+    // Calls visit(eventId, tierId, queue) for every queue
+    template <typename Visit>
+    void forEach(Visit visit) {
+        shared_lock<shared_mutex> guard(lock);
+        for (auto& entry : queues) {
+            visit((int)(entry.first >> 32), (TierId)entry.first, *entry.second);
+        }
+    }
+
+private:
+    shared_mutex lock;
+    unordered_map<uint64_t, unique_ptr<WaitQueue>> queues;
+    atomic<size_t> queueCount{0};
+
+    static uint64_t key(int eventId, TierId tierId) {
+        return (uint64_t)(uint32_t)eventId << 32 | tierId;
+    }
+};
+
+// =============== SHARED INVENTORY ===============
+// With --shared, every copy of the program started in the same data directory
+// sells from one set of tier counts, seat maps and id sequences, kept in a
+// POSIX shared memory segment named after the directory. Counts are taken
+// with the same compare-and-swap as within one process, so no tier can be
+// oversold however many processes are selling from it.
+//
+// Bookings, cancellations and new users from every process go to the one
+// bookings.journal, appended under the segment lock, and each process picks
+// up the others' records from it when it syncs. Only one process at a time,
+// the owner, writes the data files. Each of its checkpoints empties the
+// journal and bumps the generation, which tells the other processes to catch
+// up from the data files instead. When the owner exits or dies, the next
+// process to sync takes over.
+//
+// Holds and waitlists stay in the process that made them. Tickets held by a
+// process that crashes stay off sale until the segment is recreated, which
+// happens once no process is using it.
+class SharedInventory;
+
+enum SharedSequence {
+    SEQ_BOOKING,
+    SEQ_USER,
+    SEQ_EVENT
+};
+
+#ifdef BOOKING_SHARED
+static_assert(atomic<int>::is_always_lock_free && atomic<uint64_t>::is_always_lock_free,
+              "shared memory counters must not need a lock");
+
+const int SHARED_MAX_PROCESSES = 64;
+// The segment is sized by its creator from the inventory it loaded: this many
+// times what that needs, and never less than the minimums
+const uint64_t SHARED_HEADROOM = 4;
+const uint64_t SHARED_MIN_TIER_SLOTS = 1 << 12;
+const uint64_t SHARED_MIN_SEAT_BYTES = 1 << 20;
+const uint64_t SHARED_MIN_CANCEL_IDS = 1 << 26;  // booking ids with a cancelled bit
+
+// One event's tier. Slots are only claimed, never freed.
+class SharedTierSlot {
+public:
+    bool used;
+    int eventId;
+    uint64_t nameHash;
+    SharedCounts counts;
+    int seatRows;  // 0 if the tier has no seat map in the segment
+    int seatsPerRow;
+    uint64_t seatOffset;  // into the seat area
+    ProcessMutex seatLock;
+};
+
+// How a segment is divided, fixed by its creator
+class SharedLayout {
+public:
+    uint64_t tierSlots;  // a power of two
+    uint64_t seatBytes;
+    uint64_t cancelIds;
+};
+
+// The fields without atomics are only touched under lock
+class SharedHeader {
+public:
+    atomic<int> creator;  // pid, written first
+    atomic<int> ready;    // set once the creator has put its inventory in
+    ProcessMutex lock;    // slots, processes, owner and journal appends
+    bool retired;         // unlinked: attach to a new segment instead
+    int owner;            // pid writing the data files, 0 for none
+    int processes[SHARED_MAX_PROCESSES];  // pids attached, 0 for a free entry
+    atomic<uint64_t> generation;
+    atomic<int> nextIds[3];  // by SharedSequence
+    uint64_t seatBytesUsed;
+    SharedLayout layout;
+};
+
+class SharedInventory {
+public:
+    ~SharedInventory() {
+        detach();
+    }
+
+    // Opens the segment for the current directory, creating it if no other
+    // process has, with room for eventlist and bookings up to nextBookingId.
+    // A creator must call publish() once its inventory is in.
+    bool attach(const vector<Event>& eventlist, int nextBookingId) {
+        uint64_t tiers = 0, seatBytes = 0;
+        for (const auto& event : eventlist) {
+            for (const auto& tier : event.ticketTiers) {
+                tiers++;
+                if (tier.seats) seatBytes += (tier.seats->sharedSize() + 7) & ~7ull;
+            }
+        }
+        layout.tierSlots = SHARED_MIN_TIER_SLOTS;
+        while (layout.tierSlots < tiers * SHARED_HEADROOM) layout.tierSlots *= 2;  // probing masks
+        layout.seatBytes = max(SHARED_MIN_SEAT_BYTES, seatBytes * SHARED_HEADROOM);
+        layout.cancelIds = max(SHARED_MIN_CANCEL_IDS, ((uint64_t)nextBookingId * SHARED_HEADROOM + 63) & ~(uint64_t)63);
+
+        char directory[4096];
+        if (!getcwd(directory, sizeof(directory))) return false;
+        char name[32];
+        snprintf(name, sizeof(name), "/ets-%016llx",
+                 (unsigned long long)fnv1a(directory, strlen(directory)));
+        segmentName = name;
+
+        for (int attempt = 0; attempt < 10 && !tooLarge; attempt++) {
+            if (open()) return true;
+        }
+        if (tooLarge) return false;
+        cerr << "Could not attach to shared inventory " << segmentName << "\n";
+        return false;
+    }
+
+    void publish() {
+        header->ready.store(1, memory_order_release);
+    }
+
+    bool isCreator() const {
+        return created;
+    }
+
+    ProcessMutex& lock() {
+        return header->lock;
+    }
+
+    // The rest need lock() unless noted
+
+    // Makes this process the owner if there is none or the owner has gone
+    bool claimOwnership() {
+        if (header->owner != getpid() && (header->owner == 0 || !isAlive(header->owner))) {
+            header->owner = getpid();
+        }
+        return header->owner == getpid();
+    }
+
+    int owner() const {
+        return header->owner;
+    }
+
+    // No lock needed
+    uint64_t generation() const {
+        return header->generation.load(memory_order_acquire);
+    }
+
+    uint64_t nextGeneration() {
+        return header->generation.fetch_add(1, memory_order_acq_rel) + 1;
+    }
+
+    // No lock needed
+    int takeId(SharedSequence sequence) {
+        return header->nextIds[sequence].fetch_add(1, memory_order_relaxed);
+    }
+
+    // Marks the booking cancelled. Only one process can do so, so its
+    // tickets can only go back on sale once. Ids past the segment's range
+    // are not tracked. No lock needed.
+    bool claimCancel(int bookingId) {
+        if (bookingId < 0 || (uint64_t)bookingId >= header->layout.cancelIds) return true;
+        uint64_t bit = 1ull << (bookingId % 64);
+        return !(cancelBits[bookingId / 64].fetch_or(bit, memory_order_acq_rel) & bit);
+    }
+
+    // Makes sure the sequence will not hand out ids below next
+    void raiseId(SharedSequence sequence, int next) {
+        atomic<int>& id = header->nextIds[sequence];
+        int current = id.load(memory_order_relaxed);
+        while (current < next && !id.compare_exchange_weak(current, next, memory_order_relaxed)) {
+        }
+    }
+
+    // Points the tier's counts (and seat map) at its slot, claiming the slot
+    // with the tier's current state if no process has shared it yet.
+    bool shareTier(int eventId, const string& tierName, TicketTier& tier) {
+        uint64_t nameHash = fnv1a(tierName.data(), tierName.size());
+        size_t mask = header->layout.tierSlots - 1;
+        size_t start = (nameHash ^ (uint64_t)eventId * 0x9e3779b97f4a7c15ull) & mask;
+        for (size_t probe = 0; probe < header->layout.tierSlots; probe++) {
+            SharedTierSlot& slot = slots[(start + probe) & mask];
+            if (slot.used && (slot.eventId != eventId || slot.nameHash != nameHash)) continue;
+
+            bool fresh = !slot.used;
+            if (fresh) claimSlot(slot, eventId, nameHash, tier);
+            if (tier.seats && slot.seatRows == tier.seats->rows && slot.seatsPerRow == tier.seats->seatsPerRow) {
+                tier.seats->share(seatArea + slot.seatOffset, &slot.seatLock, fresh);
+            }
+            tier.shared = &slot.counts;
+            return true;
+        }
+        return false;
+    }
+
+    // Takes this process out of the segment and gives up ownership. Returns
+    // true if it was the last process using it, in which case the caller
+    // should write the data files and then retire() the segment.
+    bool leave() {
+        bool last = true;
+        for (int& pid : header->processes) {
+            if (pid == getpid()) pid = 0;
+            if (pid != 0 && isAlive(pid)) last = false;
+        }
+        if (header->owner == getpid()) header->owner = 0;
+        return last;
+    }
+
+    void retire() {
+        header->retired = true;
+        shm_unlink(segmentName.c_str());
+    }
+
+    // Leaves without writing anything, if BookingEngine has not already
+    // left. Needs no lock.
+    void detach() {
+        if (!header) return;
+        if (!left) {
+            lock_guard<ProcessMutex> guard(header->lock);
+            if (leave()) retire();
+        }
+        unmap();
+    }
+
+    bool left = false;  // set by the engine once it has left
+
+private:
+    string segmentName;
+    bool created = false;
+    bool tooLarge = false;  // /dev/shm has no room for a new segment
+    SharedLayout layout;  // for a new segment
+    size_t mappedBytes = 0;
+    char* base = nullptr;
+    SharedHeader* header = nullptr;
+    SharedTierSlot* slots = nullptr;
+    char* seatArea = nullptr;
+    atomic<uint64_t>* cancelBits = nullptr;
+
+    static size_t headerBytes() {
+        return (sizeof(SharedHeader) + 4095) & ~(size_t)4095;
+    }
+
+    static size_t segmentBytes(const SharedLayout& sizes) {
+        return headerBytes() + sizeof(SharedTierSlot) * sizes.tierSlots + sizes.seatBytes +
+               sizes.cancelIds / 8;
+    }
+
+    // Pages of a sparse segment are only taken from /dev/shm once written,
+    // and a write that finds none left kills the process with SIGBUS, so a
+    // segment is only created if all of it would fit
+    bool roomFor(int fd, size_t bytes) {
+        struct statvfs space;
+        if (fstatvfs(fd, &space) != 0) return true;
+        uint64_t available = (uint64_t)space.f_bavail * space.f_frsize;
+        if (available >= bytes) return true;
+        cerr << "Not enough shared memory for the inventory: it needs " << (bytes >> 20) + 1
+             << " MB and /dev/shm has " << (available >> 20) << " MB free\n";
+        tooLarge = true;
+        return false;
+    }
+
+    // Points slots, seatArea and cancelBits into the mapped segment
+    void locate() {
+        slots = (SharedTierSlot*)(base + headerBytes());
+        seatArea = (char*)(slots + header->layout.tierSlots);
+        cancelBits = (atomic<uint64_t>*)(seatArea + header->layout.seatBytes);
+    }
+
+    // A process killed but not yet reaped still answers kill(), so its
+    // state in /proc is checked too
+    static bool isAlive(int pid) {
+        if (kill(pid, 0) != 0 && errno != EPERM) return false;
+        char path[32];
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        ifstream stat(path);
+        string line;
+        if (!getline(stat, line)) return true;
+        size_t end = line.rfind(')');
+        return end == string::npos || end + 2 >= line.size() || line[end + 2] != 'Z';
+    }
+
+    // One try at creating or joining the segment. False means try again.
+    bool open() {
+        int fd = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        created = fd >= 0;
+        if (created) {
+            mappedBytes = segmentBytes(layout);
+            // Sparse: pages are only used once something is written to them
+            if (!roomFor(fd, mappedBytes) || ftruncate(fd, mappedBytes) != 0) {
+                close(fd);
+                shm_unlink(segmentName.c_str());
+                return false;
+            }
+        } else {
+            fd = shm_open(segmentName.c_str(), O_RDWR, 0600);
+            if (fd < 0) return false;
+            mappedBytes = waitForSize(fd);
+            if (mappedBytes == 0) {
+                removeStale(fd);
+                return false;
+            }
+        }
+
+        void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        base = (char*)mapped;
+        header = (SharedHeader*)base;
+
+        if (created) {
+            close(fd);
+            header->layout = layout;
+            locate();
+            header->creator.store(getpid(), memory_order_release);
+            header->lock.init();
+            header->owner = getpid();
+            header->processes[0] = getpid();
+            return true;
+        }
+
+        // Wait for the creator to fill it in, unless it died trying
+        auto start = chrono::steady_clock::now();
+        while (!header->ready.load(memory_order_acquire)) {
+            int creator = header->creator.load(memory_order_acquire);
+            bool gone = creator != 0 ? !isAlive(creator)
+                                     : chrono::steady_clock::now() - start > chrono::seconds(5);
+            if (gone) {
+                removeStale(fd);
+                unmap();
+                return false;
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        close(fd);
+        // The layout was written before ready; a segment is never resized
+        if (segmentBytes(header->layout) > mappedBytes) {
+            unmap();
+            return false;
+        }
+        locate();
+
+        header->lock.lock();
+        bool joined = join();
+        header->lock.unlock();
+        if (!joined) unmap();
+        return joined;
+    }
+
+    // Adds this process to a ready segment, under lock
+    bool join() {
+        if (header->retired) return false;
+
+        // Every process that used it has gone without cleaning up, so its
+        // counts may include holds nobody will return: start afresh
+        int* freeEntry = nullptr;
+        bool anyAlive = false;
+        for (int& pid : header->processes) {
+            if (pid != 0 && !isAlive(pid)) pid = 0;
+            if (pid != 0) anyAlive = true;
+            if (pid == 0 && !freeEntry) freeEntry = &pid;
+        }
+        if (!anyAlive) {
+            retire();
+            return false;
+        }
+        if (!freeEntry) {
+            cerr << "Too many processes sharing the inventory\n";
+            return false;
+        }
+        *freeEntry = getpid();
+        return true;
+    }
+
+    // The creator may not have sized it yet. Returns its size, or 0 if it
+    // never was.
+    size_t waitForSize(int fd) {
+        for (int i = 0; i < 500; i++) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && (size_t)info.st_size >= headerBytes()) return info.st_size;
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        return 0;
+    }
+
+    // Unlinks the segment fd refers to, unless the name has already moved on
+    // to a newer segment, and closes fd
+    void removeStale(int fd) {
+        struct stat opened, named;
+        if (fstat(fd, &opened) == 0 && stat(("/dev/shm" + segmentName).c_str(), &named) == 0 &&
+            opened.st_ino == named.st_ino) {
+            shm_unlink(segmentName.c_str());
+        }
+        close(fd);
+    }
+
+    void claimSlot(SharedTierSlot& slot, int eventId, uint64_t nameHash, const TicketTier& tier) {
+        slot.used = true;
+        slot.eventId = eventId;
+        slot.nameHash = nameHash;
+        slot.counts.remaining.store(tier.available());
+        slot.counts.held.store(tier.unsold() - tier.available());
+        slot.seatRows = 0;
+        slot.seatsPerRow = 0;
+        if (tier.seats) {
+            uint64_t bytes = (tier.seats->sharedSize() + 7) & ~7ull;
+            if (header->seatBytesUsed + bytes <= header->layout.seatBytes) {
+                slot.seatRows = tier.seats->rows;
+                slot.seatsPerRow = tier.seats->seatsPerRow;
+                slot.seatOffset = header->seatBytesUsed;
+                slot.seatLock.init();
+                header->seatBytesUsed += bytes;
+            } else {
+                cerr << "Shared seat area full; seats for event " << eventId << " stay per process\n";
+            }
+        }
+    }
+
+    void unmap() {
+        if (base) munmap(base, mappedBytes);
+        base = nullptr;
+        header = nullptr;
+    }
+};
+#endif
+
+// =============== BOOKING ENGINE ===============
+// Books and cancels tickets on behalf of any number of threads at once.
+// Inventory is taken with a compare-and-swap on the tier's atomic counter, so
+// buyers never wait on each other for seats and a tier can never be oversold.
+// Only appending the booking record (bookings, index, journal) is serialised.
+//
+// Events, users and tiers must not be added while bookings are in flight.
+enum BookResult {
+    BOOK_OK,
+    BOOK_UNKNOWN_USER,
+    BOOK_UNKNOWN_EVENT,
+    BOOK_UNKNOWN_TIER,
+    BOOK_INVALID_QUANTITY,
+    BOOK_SOLD_OUT,
+    BOOK_NO_HOLD,  // unknown, expired or already used hold
+    BOOK_NO_ADJACENT_SEATS,  // enough seats left, but not side by side
+    BOOK_NOT_SOLD_OUT  // waitlist refused: the tickets can be booked now
+};
+
+class BookingEngine {
+public:
+    vector<Event>& eventlist;
+    vector<User>& Userlist;
+    vector<Booking>& bookings;
+    DataIndex& index;
+    BookingJournal& journal;
+    atomic<int> nextBookingId;
+    int nextUserId;
+    int nextEventId;
+    // The one ordered append: bookings, index, journal, totals and pages
+    // change together under it, so a checkpoint or report copies a
+    // consistent set and ids go to the journal in order. Held only for the
+    // append; reserving tickets (a CAS on the tier) never waits for it.
+    mutex bookingsMutex;
+    // Striped by event id. A stripe is held shared by every operation that
+    // moves tickets between that event's tiers and the bookings; all of
+    // them are held exclusively while both are copied for a checkpoint, so
+    // it never sees tickets that have left a tier before their booking is
+    // recorded. Bookings for different events never share a stripe's
+    // cache line. Taken before bookingsMutex.
+    static const int COUNTS_STRIPES = 64;
+    class CountsStripe {
+    public:
+        alignas(64) shared_mutex lock;
+    };
+    CountsStripe countsLocks[COUNTS_STRIPES];
+    // Copy-on-write, like a BookingPage: snapshots share the aggregates and
+    // the next change copies them if one still does. Change them through
+    // changeTotals.
+    shared_ptr<SalesAggregates> totals = make_shared<SalesAggregates>();
+    BookingPages pages;
+    HoldWheel holds;
+    Waitlists waitlists;
+    SharedInventory* shared = nullptr;  // set by shareInventory
+    atomic<bool> compactionDue{false};  // see compactJournal
+
+    BookingEngine(vector<Event>& events, vector<User>& users, vector<Booking>& bookingList,
+                  DataIndex& dataIndex, BookingJournal& bookingJournal)
+        : eventlist(events), Userlist(users), bookings(bookingList),
+          index(dataIndex), journal(bookingJournal), nextBookingId(1),
+          nextUserId(getnextUserID(users)), nextEventId(getNextEventID(events)) {
+        if (!bookings.empty()) {
+            nextBookingId = bookings.back().bookingId + 1;
+        }
+        totals->rebuild(bookings);
+        pages.build(bookings);
+        markBookedSeats();
+        loadWaitlist();
+    }
+
+    ~BookingEngine() {
+        leaveShared();
+    }
+
+    BookResult book(int userId, int eventId, const string& tierName, int quantity, int& bookingId) {
+        OpTimer timer(STAT_BOOK);
+        CountsGuard counts(*this, eventId);
+        if (!index.findUser(Userlist, userId)) return BOOK_UNKNOWN_USER;
+        Event* event = index.findEvent(eventlist, eventId);
+        if (!event) return BOOK_UNKNOWN_EVENT;
+        TicketTier* tier = event->findTier(tierName);
+        if (!tier) return BOOK_UNKNOWN_TIER;
+        if (quantity <= 0) return BOOK_INVALID_QUANTITY;
+        if (!tier->tryReserve(quantity)) return BOOK_SOLD_OUT;
+
+        int seatId = -1;
+        if (tier->seats) {
+            seatId = tier->seats->reserveBest(quantity);
+            if (seatId < 0) {
+                tier->release(quantity);
+                return BOOK_NO_ADJACENT_SEATS;
+            }
+        }
+        bookingId = recordBooking(userId, eventId, quantity, quantity * tier->price, tier->nameId, seatId);
+        return BOOK_OK;
+    }
+
+    // Takes the tickets (and seats) out of the tier for holdSeconds without
+    // booking them. Fills in the hold, including its id, on success.
+    BookResult hold(int userId, int eventId, const string& tierName, int quantity, SeatHold& seatHold,
+                    int holdSeconds = DEFAULT_HOLD_SECONDS) {
+        OpTimer timer(STAT_HOLD);
+        expireHolds();
+        CountsGuard counts(*this, eventId);
+        if (!index.findUser(Userlist, userId)) return BOOK_UNKNOWN_USER;
+        Event* event = index.findEvent(eventlist, eventId);
+        if (!event) return BOOK_UNKNOWN_EVENT;
+        TicketTier* tier = event->findTier(tierName);
+        if (!tier) return BOOK_UNKNOWN_TIER;
+        if (quantity <= 0) return BOOK_INVALID_QUANTITY;
+        if (!tier->tryHold(quantity)) return BOOK_SOLD_OUT;
+
+        seatHold = SeatHold();
+        if (tier->seats) {
+            seatHold.seatId = tier->seats->reserveBest(quantity);
+            if (seatHold.seatId < 0) {
+                tier->releaseHold(quantity);
+                return BOOK_NO_ADJACENT_SEATS;
+            }
+        }
+        seatHold.userId = userId;
+        seatHold.eventId = eventId;
+        seatHold.tierId = tier->nameId;
+        seatHold.quantity = quantity;
+        seatHold.totalPrice = quantity * tier->price;
+        seatHold.holdId = holds.add(seatHold, holdSeconds);
+        return BOOK_OK;
+    }
+
+    // Books the held tickets at the price quoted when they were held
+    BookResult confirmHold(int holdId, int& bookingId) {
+        OpTimer timer(STAT_CONFIRM);
+        expireHolds();
+        SeatHold seatHold;
+        if (!holds.take(holdId, seatHold)) return BOOK_NO_HOLD;
+        CountsGuard counts(*this, seatHold.eventId);
+        if (TicketTier* tier = findHeldTier(seatHold)) tier->confirmHold(seatHold.quantity);
+
+        bookingId = recordBooking(seatHold.userId, seatHold.eventId, seatHold.quantity,
+                                  seatHold.totalPrice, seatHold.tierId, seatHold.seatId);
+        return BOOK_OK;
+    }
+
+    bool releaseHold(int holdId) {
+        SeatHold seatHold;
+        if (!holds.take(holdId, seatHold)) return false;
+        CountsGuard counts(*this, seatHold.eventId);
+        returnHeldTickets(seatHold);
+        return true;
+    }
+
+    // Puts the tickets of expired holds back on sale. Called before every
+    // hold and confirmation, and periodically by the menus and the server.
+    void expireHolds() {
+        vector<SeatHold> expired;
+        holds.expire(expired);
+        for (const auto& seatHold : expired) {
+            CountsGuard counts(*this, seatHold.eventId);
+            returnHeldTickets(seatHold);
+        }
+    }
+
+    // Cancels a confirmed booking and hands its tickets to the tier's
+    // waitlist, and whatever the waitlist does not take back to the tier.
+    // Fills in the cancelled booking and the ids of the bookings made for
+    // waiting customers on success.
+    bool cancel(int bookingId, Booking* cancelled = nullptr, vector<int>* promoted = nullptr) {
+        OpTimer timer(STAT_CANCEL);
+        TicketTier* tier = nullptr;
+        int eventId, quantity;
+        uint64_t record;
+        {
+            lock_guard<mutex> lock(bookingsMutex);
+            Booking* booking = index.findBooking(bookings, bookingId);
+            if (!booking || booking->status != STATUS_CONFIRMED) return false;
+            #ifdef BOOKING_SHARED
+            if (shared && !shared->claimCancel(bookingId)) {
+                // Another process got there first; its record is on the way
+                cancelShared(bookingId);
+                return false;
+            }
+            #endif
+
+            booking->status = STATUS_CANCELLED;
+            changeTotals().recordCancel(*booking);
+            pages.setStatus(booking - bookings.data(), STATUS_CANCELLED);
+            eventId = booking->eventId;
+            quantity = booking->tickets;
+            if (Event* event = index.findEvent(eventlist, eventId)) {
+                tier = event->findTier(booking->tierId);
+                if (tier && tier->seats && booking->seatId >= 0) {
+                    tier->seats->release(booking->seatId, quantity);
+                }
+                if (tier) tier->holdReturned(quantity);
+            }
+            if (cancelled) *cancelled = *booking;
+
+            record = journal.appendCancel(bookingId);
+            compactJournal();
+        }
+        journal.waitDurable(record);
+        // The tickets went back to the tier under bookingsMutex, so only
+        // the promotion needs the event's stripe
+        CountsGuard counts(*this, eventId);
+        if (tier) promoteWaiting(eventId, *tier, quantity, promoted);
+        return true;
+    }
+
+    // Queues the user for a tier that cannot supply quantity tickets now.
+    // Fills in the user's place in the queue on success.
+    BookResult joinWaitlist(int userId, int eventId, const string& tierName, int quantity, int& position) {
+        CountsGuard counts(*this, eventId);
+        if (!index.findUser(Userlist, userId)) return BOOK_UNKNOWN_USER;
+        Event* event = index.findEvent(eventlist, eventId);
+        if (!event) return BOOK_UNKNOWN_EVENT;
+        TicketTier* tier = event->findTier(tierName);
+        if (!tier) return BOOK_UNKNOWN_TIER;
+        if (quantity <= 0) return BOOK_INVALID_QUANTITY;
+        if (tier->seats && quantity > tier->seats->seatsPerRow) return BOOK_NO_ADJACENT_SEATS;
+        if (tier->available() >= quantity) return BOOK_NOT_SOLD_OUT;
+
+        Waiter waiter;
+        waiter.userId = userId;
+        waiter.quantity = quantity;
+        position = waitlists.obtain(eventId, tier->nameId).push(waiter);
+
+        // Tickets may have come back between the check and the join
+        if (tier->available() > 0) promoteWaiting(eventId, *tier, 0, nullptr);
+        return BOOK_OK;
+    }
+
+    // Every booking as it stands now, with the totals for exactly those
+    // rows, for reads that take a while (see BOOKING SNAPSHOTS). Costs a
+    // pointer per page; writers wait only for that.
+    BookingSnapshot snapshot() {
+        lock_guard<mutex> lock(bookingsMutex);
+        return takeSnapshot();
+    }
+
+    // A snapshot that also lists one user's rows, so a view of that user's
+    // bookings need not read the live index
+    BookingSnapshot userSnapshot(int userId) {
+        lock_guard<mutex> lock(bookingsMutex);
+        BookingSnapshot taken = takeSnapshot();
+        taken.userRows = index.userBookings(userId);
+        return taken;
+    }
+
+    // A snapshot for sales reports on the events at eventPositions, with
+    // their unsold tickets beside the rows. Tickets leave a tier before their
+    // booking is recorded, so this waits for operations in flight on those
+    // events only; bookings for other events carry on.
+    BookingSnapshot reportSnapshot(const vector<size_t>& eventPositions) {
+        vector<int> eventIds;
+        eventIds.reserve(eventPositions.size());
+        for (size_t pos : eventPositions) eventIds.push_back(eventlist[pos].eventID);
+        EventCounts quiet(*this, eventIds);
+        lock_guard<mutex> lock(bookingsMutex);
+        BookingSnapshot taken = takeSnapshot();
+        taken.unsold.reserve(eventPositions.size());
+        for (size_t pos : eventPositions) {
+            const Event& event = eventlist[pos];
+            vector<int>& counts = taken.unsold[event.eventID];
+            for (const auto& tier : event.ticketTiers) counts.push_back(tier.unsold());
+        }
+        return taken;
+    }
+
+    int waitlistLength(int eventId, TierId tierId) {
+        WaitQueue* queue = waitlists.find(eventId, tierId);
+        return queue ? queue->size() : 0;
+    }
+
+    int newUserId() {
+        return shared ? sharedId(SEQ_USER) : nextUserId++;
+    }
+
+    // Registers a user with an id from newUserId. Only while no bookings are
+    // in flight. Other processes sharing the inventory learn of the user
+    // from the journal; otherwise the caller saves users.txt.
+    void addUser(const User& user) {
+        Userlist.push_back(user);
+        index.addUser(Userlist, Userlist.size() - 1);
+        if (shared) journal.waitDurable(journal.appendUser(user));
+    }
+
+    // Only the owner of the data files can add events when sharing the
+    // inventory, since adding one writes a checkpoint
+    bool canAddEvents() {
+        #ifdef BOOKING_SHARED
+        if (shared) {
+            lock_guard<ProcessMutex> sharedLock(shared->lock());
+            return shared->claimOwnership();
+        }
+        #endif
+        return true;
+    }
+
+    int ownerProcess() {
+        #ifdef BOOKING_SHARED
+        if (shared) {
+            lock_guard<ProcessMutex> sharedLock(shared->lock());
+            return shared->owner();
+        }
+        #endif
+        return 0;
+    }
+
+    int newEventId() {
+        return shared ? sharedId(SEQ_EVENT) : nextEventId++;
+    }
+
+    // Registers a new event and writes a checkpoint (see BookingJournal).
+    // Fails if another process owns the data files (see canAddEvents).
+    bool addEvent(const Event& event) {
+        if (!canAddEvents()) return false;
+        AllCounts quiet(*this);
+        lock_guard<mutex> lock(bookingsMutex);
+        eventlist.push_back(event);
+        index.addEvent(eventlist, eventlist.size() - 1);
+        #ifdef BOOKING_SHARED
+        if (shared) {
+            lock_guard<ProcessMutex> sharedLock(shared->lock());
+            shareTiers(eventlist.back());
+        }
+        #endif
+        writeCheckpoint();
+        return true;
+    }
+
+    // Appends a booking loaded in bulk (see BULK IMPORT) without journaling
+    // it; the importer writes a checkpoint at the end. Seats are the
+    // importer's job. Only while no bookings are in flight.
+    void addImported(const Booking& booking) {
+        bookings.push_back(booking);
+        index.addBooking(bookings, bookings.size() - 1);
+        changeTotals().recordBooking(booking);
+        pages.append(booking);
+        if (booking.bookingId >= nextBookingId) nextBookingId = booking.bookingId + 1;
+    }
+
+    // Promotion takes a queue's consumer mutex before bookingsMutex, so the
+    // waitlist is saved after the lock is given up. When sharing the
+    // inventory only the owner writes, waitlist included.
+    void checkpoint() {
+        AllCounts quiet(*this);
+        bool written;
+        {
+            lock_guard<mutex> lock(bookingsMutex);
+            written = writeCheckpoint();
+        }
+        if (written) saveWaitlist();
+    }
+
+    #ifdef BOOKING_SHARED
+    // Moves every tier's counts and seats and the id sequences into the
+    // shared inventory, then catches up with what other processes have
+    // done since the data files were written. Before any bookings are made.
+    void shareInventory(SharedInventory& inventory) {
+        lock_guard<mutex> lock(bookingsMutex);
+        lock_guard<ProcessMutex> sharedLock(inventory.lock());
+        shared = &inventory;
+        journal.appendLock = &inventory.lock();
+        inventory.raiseId(SEQ_BOOKING, nextBookingId);
+        inventory.raiseId(SEQ_USER, nextUserId);
+        inventory.raiseId(SEQ_EVENT, nextEventId);
+        for (auto& event : eventlist) shareTiers(event);
+        // The data files may have been read while the owner was rewriting
+        // them, so others read them again under the lock. The creator's
+        // waitlist came from waitlist.txt and must not be served twice.
+        if (inventory.isCreator()) {
+            seenGeneration = inventory.generation();
+        } else {
+            seenGeneration = inventory.generation() - 1;
+            waitlists.clear();
+        }
+        catchUp();
+    }
+    #endif
+
+    // The last process to leave the shared inventory writes the data files,
+    // which by then include every other process's records
+    void leaveShared() {
+        #ifdef BOOKING_SHARED
+        if (!shared) return;
+        AllCounts quiet(*this);
+        lock_guard<mutex> lock(bookingsMutex);
+        lock_guard<ProcessMutex> sharedLock(shared->lock());
+        if (shared->leave()) {
+            catchUp();
+            writeOwnerCheckpoint();
+            shared->retire();
+        }
+        shared->left = true;
+        shared = nullptr;
+        #endif
+    }
+
+    // Picks up the users, events, bookings and cancellations other processes
+    // sharing the inventory have made; the owner also checkpoints once the
+    // journal is large. Then serves this process's waitlists from tickets
+    // others have put back on sale. Only while no bookings are in flight.
+    void syncShared() {
+        #ifdef BOOKING_SHARED
+        if (!shared) return;
+        {
+            AllCounts quiet(*this);
+            lock_guard<mutex> lock(bookingsMutex);
+            lock_guard<ProcessMutex> sharedLock(shared->lock());
+            catchUp();
+            if (journalOffset >= journal.compactThreshold && shared->claimOwnership()) {
+                writeOwnerCheckpoint();
+            }
+        }
+        vector<pair<int, TicketTier*>> servable;
+        waitlists.forEach([&](int eventId, TierId tierId, WaitQueue& queue) {
+            Event* event = index.findEvent(eventlist, eventId);
+            TicketTier* tier = event ? event->findTier(tierId) : nullptr;
+            if (tier && queue.size() > 0 && tier->available() > 0) servable.emplace_back(eventId, tier);
+        });
+        for (auto& [eventId, tier] : servable) {
+            CountsGuard counts(*this, eventId);
+            promoteWaiting(eventId, *tier, 0, nullptr);
+        }
+        #endif
+    }
+
+private:
+    // Holds the event's counts stripe shared for an operation, then runs a
+    // compaction the operation asked for once it has let go
+    class CountsGuard {
+    public:
+        CountsGuard(BookingEngine& bookingEngine, int eventId)
+            : engine(bookingEngine), lock(bookingEngine.countsStripe(eventId)) {}
+
+        ~CountsGuard() {
+            lock.unlock();
+            engine.compactIfDue();
+        }
+
+    private:
+        BookingEngine& engine;
+        shared_lock<shared_mutex> lock;
+    };
+
+    // Holds the counts stripes of some events exclusively, taken in index
+    // order like AllCounts
+    class EventCounts {
+    public:
+        EventCounts(BookingEngine& bookingEngine, const vector<int>& eventIds) : engine(bookingEngine) {
+            for (int eventId : eventIds) stripes.push_back((unsigned)eventId % COUNTS_STRIPES);
+            sort(stripes.begin(), stripes.end());
+            stripes.erase(unique(stripes.begin(), stripes.end()), stripes.end());
+            for (unsigned stripe : stripes) engine.countsLocks[stripe].lock.lock();
+        }
+
+        ~EventCounts() {
+            for (auto it = stripes.rbegin(); it != stripes.rend(); ++it) engine.countsLocks[*it].lock.unlock();
+        }
+
+    private:
+        BookingEngine& engine;
+        vector<unsigned> stripes;
+    };
+
+    // Holds every counts stripe exclusively, taken in index order
+    class AllCounts {
+    public:
+        AllCounts(BookingEngine& bookingEngine) : engine(bookingEngine) {
+            for (auto& stripe : engine.countsLocks) stripe.lock.lock();
+        }
+
+        ~AllCounts() {
+            for (int i = COUNTS_STRIPES - 1; i >= 0; i--) engine.countsLocks[i].lock.unlock();
+        }
+
+    private:
+        BookingEngine& engine;
+    };
+
+    shared_mutex& countsStripe(int eventId) {
+        return countsLocks[(unsigned)eventId % COUNTS_STRIPES].lock;
+    }
+
+    // Under bookingsMutex
+    SalesAggregates& changeTotals() {
+        if (totals.use_count() > 1) totals = make_shared<SalesAggregates>(*totals);
+        return *totals;
+    }
+
+    // Under bookingsMutex
+    BookingSnapshot takeSnapshot() const {
+        BookingSnapshot taken = pages.snapshot();
+        taken.totals = totals;
+        return taken;
+    }
+
+    // Returns once the booking is in the journal on disk
+    int recordBooking(int userId, int eventId, int quantity, float totalPrice, TierId tierId, int seatId) {
+        int bookingId;
+        uint64_t record;
+        {
+            lock_guard<mutex> lock(bookingsMutex);
+            bookingId = shared ? sharedId(SEQ_BOOKING) : nextBookingId++;
+            bookings.emplace_back(bookingId, userId, eventId, quantity, totalPrice, tierId, seatId);
+            index.addBooking(bookings, bookings.size() - 1);
+            changeTotals().recordBooking(bookings.back());
+            pages.append(bookings.back());
+            const Event* event = index.findEvent(eventlist, eventId);  // booked through it
+            record = journal.appendBooking(bookings.back(), event->tierName(tierId));
+            compactJournal();
+        }
+        journal.waitDurable(record);
+        return bookingId;
+    }
+
+    TicketTier* findHeldTier(const SeatHold& seatHold) {
+        Event* event = index.findEvent(eventlist, seatHold.eventId);
+        return event ? event->findTier(seatHold.tierId) : nullptr;
+    }
+
+    void returnHeldTickets(const SeatHold& seatHold) {
+        TicketTier* tier = findHeldTier(seatHold);
+        if (!tier) return;
+        if (tier->seats && seatHold.seatId >= 0) tier->seats->release(seatHold.seatId, seatHold.quantity);
+        promoteWaiting(seatHold.eventId, *tier, seatHold.quantity, nullptr);
+    }
+
+    // Books tickets for the tier's waiting customers, oldest first. freed
+    // tickets have just come back and are still counted as held; the rest
+    // come from the tier's remaining count. Stops at the first customer who
+    // cannot be served, so nobody is overtaken, and puts any freed tickets
+    // left over on sale.
+    void promoteWaiting(int eventId, TicketTier& tier, int freed, vector<int>* promoted) {
+        if (WaitQueue* queue = waitlists.find(eventId, tier.nameId)) {
+            lock_guard<mutex> consumer(queue->consumer);
+            while (const Waiter* waiter = queue->peek()) {
+                int fromFreed = min(freed, waiter->quantity);
+                int fromSale = waiter->quantity - fromFreed;
+                if (fromSale > 0 && !tier.tryReserve(fromSale)) break;
+
+                int seatId = -1;
+                if (tier.seats) {
+                    seatId = tier.seats->reserveBest(waiter->quantity);
+                    if (seatId < 0) {
+                        if (fromSale > 0) tier.release(fromSale);
+                        break;
+                    }
+                }
+                // Out of held before the booking is recorded, as in confirmHold
+                tier.confirmHold(fromFreed);
+                freed -= fromFreed;
+                int bookingId = recordBooking(waiter->userId, eventId, waiter->quantity,
+                                              waiter->quantity * tier.price, tier.nameId, seatId);
+                if (promoted) promoted->push_back(bookingId);
+                queue->pop();
+            }
+        }
+        if (freed > 0) tier.releaseHold(freed);
+    }
+
+    // waitlist.txt: eventId,userId,tier,quantity per waiting customer, in
+    // queue order. Written at checkpoints; waiters for events or tiers that
+    // no longer exist are dropped on load.
+    void loadWaitlist() {
+        vector<WaitlistRecord> records;
+        TierScope tiers(eventlist);
+        loadRecords("waitlist.txt", records, tiers);
+        for (const auto& record : records) {
+            Event* event = index.findEvent(eventlist, record.eventId);
+            if (record.quantity <= 0 || !event || !event->findTier(record.tierId)) continue;
+            Waiter waiter;
+            waiter.userId = record.userId;
+            waiter.quantity = record.quantity;
+            waitlists.obtain(record.eventId, record.tierId).push(waiter);
+        }
+    }
+
+    void saveWaitlist() {
+        RecordWriter out("waitlist.txt");
+        if (!out) {
+            cerr << "Error saving waitlist\n";
+            return;
+        }
+        TierScope tiers(eventlist);
+        WaitlistRecord record;
+        waitlists.forEach([&](int eventId, TierId tierId, WaitQueue& queue) {
+            lock_guard<mutex> consumer(queue.consumer);
+            record.eventId = eventId;
+            record.tierId = tierId;
+            queue.forEach([&](const Waiter& waiter) {
+                record.userId = waiter.userId;
+                record.quantity = waiter.quantity;
+                RecordFormat<WaitlistRecord>::write(out, record, tiers);
+            });
+        });
+    }
+
+    // Seat maps start empty when loaded; fill in the confirmed bookings
+    void markBookedSeats() {
+        for (const auto& booking : bookings) {
+            if (booking.status != STATUS_CONFIRMED || booking.seatId < 0) continue;
+            Event* event = index.findEvent(eventlist, booking.eventId);
+            TicketTier* tier = event ? event->findTier(booking.tierId) : nullptr;
+            if (tier && tier->seats) tier->seats->markTaken(booking.seatId, booking.tickets);
+        }
+    }
+
+    // Text snapshot first: the binary snapshot records the state of the
+    // .txt files it was taken alongside. Returns false if another process
+    // owns the data files.
+    bool writeCheckpoint() {
+        #ifdef BOOKING_SHARED
+        if (shared) {
+            lock_guard<ProcessMutex> sharedLock(shared->lock());
+            if (!shared->claimOwnership()) return false;
+            catchUp();
+            writeOwnerCheckpoint();
+            return true;
+        }
+        #endif
+        journal.checkpoint(eventlist, bookings);
+        writeSnapshotFile(Userlist, eventlist, bookings);
+        return true;
+    }
+
+    // The shared journal is compacted by the owner when it syncs: renaming
+    // it would leave the other processes appending to the old file.
+    // Compaction copies the counts, so it must wait for every operation in
+    // flight: here, under bookingsMutex, it is only asked for.
+    void compactJournal() {
+        if (!shared && journal.full()) compactionDue.store(true, memory_order_relaxed);
+    }
+
+    void compactIfDue() {
+        if (!compactionDue.load(memory_order_relaxed) || !compactionDue.exchange(false)) return;
+        AllCounts quiet(*this);
+        lock_guard<mutex> lock(bookingsMutex);
+        journal.compactIfNeeded(Userlist, eventlist, pages.snapshot());
+    }
+
+    int sharedId(SharedSequence sequence) {
+        #ifdef BOOKING_SHARED
+        return shared->takeId(sequence);
+        #else
+        return 0;
+        #endif
+    }
+
+    #ifdef BOOKING_SHARED
+    uint64_t seenGeneration = 0;
+    streamoff journalOffset = 0;  // how far this process has read the journal
+
+    // The rest need bookingsMutex and the shared lock
+
+    void shareTiers(Event& event) {
+        for (auto& tier : event.ticketTiers) {
+            if (!shared->shareTier(event.eventID, event.tierName(tier), tier)) {
+                cerr << "Shared inventory full; event " << event.eventID << " is sold per process\n";
+            }
+        }
+    }
+
+    // Applies what other processes have written since this one last looked.
+    // After a checkpoint by some other process the records missed are only
+    // in the data files, so those are merged in first.
+    void catchUp() {
+        if (shared->generation() != seenGeneration) {
+            mergeDataFiles();
+            seenGeneration = shared->generation();
+            journalOffset = 0;
+        }
+        optional<TierScope> tiers;  // built for the first booking read
+        journal.readFrom(journalOffset, [&](JournalRecord& record) {
+            if (record.kind == 'B') {
+                if (!tiers) tiers.emplace(eventlist);
+                if (record.resolveTier(*tiers)) applyShared(record.booking);
+            } else if (record.kind == 'C') {
+                cancelShared(record.booking.bookingId);
+            } else if (record.kind == 'U' && !index.findUser(Userlist, record.user.UserId)) {
+                Userlist.push_back(record.user);
+                index.addUser(Userlist, Userlist.size() - 1);
+            }
+        });
+    }
+
+    void mergeDataFiles() {
+        vector<User> savedUsers;
+        vector<Event> savedEvents;
+        vector<Booking> savedBookings;
+        loadDataFiles(savedUsers, savedEvents, savedBookings);
+        for (auto& user : savedUsers) {
+            if (index.findUser(Userlist, user.UserId)) continue;
+            Userlist.push_back(move(user));
+            index.addUser(Userlist, Userlist.size() - 1);
+        }
+        // Saved bookings new to this process number their tier in the saved
+        // copy of their event. Name them before the events are merged, then
+        // look the names up in the live events.
+        TierScope savedTiers(savedEvents);
+        vector<string> newTierNames(savedBookings.size());
+        for (size_t i = 0; i < savedBookings.size(); i++) {
+            const Booking& booking = savedBookings[i];
+            if (index.findBooking(bookings, booking.bookingId)) continue;
+            newTierNames[i] = savedTiers.name(booking.eventId, booking.tierId);
+        }
+        for (auto& event : savedEvents) {
+            if (index.findEvent(eventlist, event.eventID)) continue;
+            eventlist.push_back(move(event));
+            index.addEvent(eventlist, eventlist.size() - 1);
+            shareTiers(eventlist.back());
+        }
+        TierScope tiers(eventlist);
+        for (size_t i = 0; i < savedBookings.size(); i++) {
+            Booking& booking = savedBookings[i];
+            if (!newTierNames[i].empty() && !tiers.intern(booking.eventId, newTierNames[i], booking.tierId)) continue;
+            applyShared(booking);
+        }
+    }
+
+    // Records a booking made by another process (this process's own are
+    // already known). The shared counts and seats already include it.
+    void applyShared(const Booking& booking) {
+        if (index.findBooking(bookings, booking.bookingId)) {
+            if (booking.status == STATUS_CANCELLED) cancelShared(booking.bookingId);
+            return;
+        }
+        bookings.push_back(booking);
+        index.addBooking(bookings, bookings.size() - 1);
+        changeTotals().recordBooking(booking);
+        pages.append(booking);
+    }
+
+    void cancelShared(int bookingId) {
+        Booking* booking = index.findBooking(bookings, bookingId);
+        if (!booking || booking->status != STATUS_CONFIRMED) return;
+        booking->status = STATUS_CANCELLED;
+        changeTotals().recordCancel(*booking);
+        pages.setStatus(booking - bookings.data(), STATUS_CANCELLED);
+    }
+
+    // Folds everything into the data files and empties the journal, which
+    // sends the other processes to the data files for what they missed
+    void writeOwnerCheckpoint() {
+        saveUsers(Userlist);
+        journal.checkpoint(eventlist, bookings);
+        writeSnapshotFile(Userlist, eventlist, bookings);
+        seenGeneration = shared->nextGeneration();
+        journalOffset = 0;
+    }
+    #endif
+};
+
+// =============== BUSINESS LOGIC ===============
+bool adminlogin() {
+    const string ADMIN_UserN = "admin";
+    const string ADMIN_Pass = "admin123";
+
+    showScreenHeader("ADMIN LOGIN");
+    string username = getlineinput("Username: ");
+    
+    // Password input
+    cout << "Password: ";
+    #ifdef _WIN32
+    HANDLE hStdin = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD mode;
+    GetConsoleMode(hStdin, &mode);
+    SetConsoleMode(hStdin, mode & (~ENABLE_ECHO_INPUT));
+    #else
+    termios oldt;
+    tcgetattr(STDIN_FILENO, &oldt);
+    termios newt = oldt;
+    newt.c_lflag &= ~ECHO;
+    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    #endif
+
+    string password;
+    getline(cin, password);
+    
+    #ifdef _WIN32
+    SetConsoleMode(hStdin, mode);
+    #else
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    #endif
+
+    cout << endl;
+    
+    if (username != ADMIN_UserN || password != ADMIN_Pass) {
+        cout << "Access denied! Invalid credentials. Press Enter to return...";
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        return false;
+    }
+    return true;
+}
+void displayAllEvents(const vector<Event>& eventlist, const string& title = "ALL EVENTS") {
+    Pager pager(title);
+    if (eventlist.empty()) {
+        pager.add("No events registered yet.");
+        pager.show();
+        return;
+    }
+
+    ostringstream text;
+    text << left << string(102, '=') << "\n"
+         << setw(6) << "ID"
+         << setw(30) << "EVENT NAME"
+         << setw(26) << "LOCATION"
+         << setw(17) << "DATE"
+         << "TOTAL TICKETS AVAILABLE"
+         << "\n" << string(102, '=');
+    pager.heading(text.str());
+
+    for (const auto& event : eventlist) {
+        // Basic event info
+        text.str("");
+        text << left << setw(6) << event.eventID
+             << setw(30) << (event.eventName.length() > 24 ? event.eventName.substr(0, 21) + "..." : event.eventName)
+             << setw(26) << (event.eventLocation.length() > 19 ? event.eventLocation.substr(0, 16) + "..." : event.eventLocation)
+             << setw(17) << event.eventDate
+             << event.getTotalTickets();
+
+        // Ticket tiers (display first 2 tiers with ellipsis if more)
+        int tierCount = 0;
+        for (const auto& tier : event.ticketTiers) {
+            if (tierCount < 2) {
+                text << "\n     - " << setw(12) << event.tierName(tier)
+                     << "$" << fixed << setprecision(2) << tier.price
+                     << " (" << tier.available() << ")";
+            }
+            tierCount++;
+        }
+        if (tierCount > 2) {
+            text << "\n     + " << (tierCount - 2) << " more tiers...";
+        }
+
+        text << "\n" << string(102, '-');
+        pager.add(text.str());
+    }
+    pager.show();
+}
+void displayAllUsers(const vector<User>& userList) {
+    Pager pager("ALL USERS");
+    if (userList.empty()) {
+        pager.add("No users registered.");
+        pager.show();
+        return;
+    }
+
+    // Table header
+    ostringstream text;
+    text << left << string(21, '=') << "\n"
+         << setw(10) << "USER ID" << "USER NAME"
+         << "\n" << string(21, '=');
+    pager.heading(text.str());
+
+    // Table rows
+    for (const auto& user : userList) {
+        text.str("");
+        text << left << setw(10) << user.UserId << user.UserName
+             << "\n" << string(21, '-');
+        pager.add(text.str());
+    }
+
+    // Footer with count
+    pager.add("\nTotal Users: " + to_string(userList.size()));
+    pager.show();
+}
+void viewAllBookingsAdmin(const BookingSnapshot& bookings, const vector<User>& Userlist, const vector<Event>& eventlist, const DataIndex& index) {
+    Pager pager("ALL BOOKINGS - ADMIN VIEW");
+    if (bookings.empty()) {
+        pager.add("No bookings found.");
+        pager.show();
+        return;
+    }
+
+    // Group the snapshot's rows by user, users in ID order. Every row is
+    // printed anyway, and grouping here keeps the reader off the live index.
+    map<int, vector<size_t>> rowsByUser;
+    for (size_t pos = 0; pos < bookings.size(); pos++) {
+        rowsByUser[bookings[pos].userId].push_back(pos);
+    }
+
+    // Totals as they stood with these rows, so bookings made while the
+    // report runs appear in neither
+    const SalesAggregates& totals = *bookings.totals;
+
+    // One block per user
+    ostringstream text;
+    text << left << fixed << setprecision(2);
+    for (const auto& [userId, bookingsList] : rowsByUser) {
+
+        // Find user details
+        const User* user = index.findUser(Userlist, userId);
+        string userName = user ? user->UserName : "Unknown";
+
+        text.str("");
+        text << "\n===== USER: " << userName << " (ID: " << userId << ") =====\n";
+        text << "-------------------------------------------------------------\n";
+        text << setw(12) << "Booking ID"
+             << setw(12) << "Event ID"
+             << setw(20) << "Event Name"
+             << setw(12) << "Date"
+             << setw(15) << "Ticket Tier"
+             << setw(8) << "Tickets"
+             << setw(12) << "Total Price"
+             << "Status\n";
+        text << "-------------------------------------------------------------\n";
+
+        for (size_t pos : bookingsList) {
+            const Booking* booking = &bookings[pos];
+
+            // Find event details
+            const Event* event = index.findEvent(eventlist, booking->eventId);
+            const string& eventName = event ? event->eventName : "Unknown";
+            const string& eventDate = event ? event->eventDate : "Unknown";
+
+            text << setw(12) << booking->bookingId
+                 << setw(12) << booking->eventId
+                 << setw(20) << eventName
+                 << setw(12) << eventDate
+                 << setw(15) << (event ? event->tierName(booking->tierId) : "Unknown")
+                 << setw(8) << booking->tickets
+                 << "$" << setw(11) << booking->totalPrice
+                 << statusName(booking->status) << "\n";
+        }
+
+        const SalesTotals& userTotals = totals.forUser(userId);
+        text << "-------------------------------------------------------------\n";
+        text << "USER TOTALS: " << userTotals.tickets << " tickets | $" << userTotals.revenue();
+        pager.add(text.str());
+    }
+
+    // Per-event totals, with a line for each tier that has sold
+    pager.add("\n===== EVENT TOTALS =====");
+    for (const auto& event : eventlist) {
+        auto tiers = totals.byEventTier.find(event.eventID);
+        if (tiers == totals.byEventTier.end()) continue;
+
+        const SalesTotals& eventTotals = totals.forEvent(event.eventID);
+        text.str("");
+        text << event.eventName << " (ID: " << event.eventID << "): "
+             << eventTotals.tickets << " tickets | $" << eventTotals.revenue()
+             << " | " << eventTotals.cancelled << " cancelled";
+        for (const auto& [tierId, tierTotals] : tiers->second) {
+            text << "\n   - " << setw(12) << event.tierName(tierId) << tierTotals.tickets << " tickets | $"
+                 << tierTotals.revenue();
+        }
+        pager.add(text.str());
+    }
+
+    // Add system-wide totals
+    text.str("");
+    text << "\n===== SYSTEM TOTALS =====\n";
+    text << "TOTAL BOOKINGS: " << bookings.size() << " (Confirmed: " << totals.system.confirmed
+         << ", Cancelled: " << totals.system.cancelled << ")\n";
+    text << "TOTAL CONFIRMED TICKETS: " << totals.system.tickets << "\n";
+    text << "TOTAL REVENUE: $" << totals.system.revenue();
+    pager.add(text.str());
+    pager.show();
+}
+
+void viewOperationalStats() {
+    showScreenHeader("OPERATIONAL STATS");
+    array<OpSummary, STAT_OP_COUNT> summaries = OpStats::summarize();
+
+    cout << "Uptime: " << fixed << setprecision(1) << OpStats::uptimeSeconds() << " s\n\n";
+    cout << left << setw(16) << "Operation"
+         << right << setw(10) << "Count"
+         << setw(10) << "Per sec"
+         << setw(12) << "p50 (us)"
+         << setw(12) << "p90 (us)"
+         << setw(12) << "p99 (us)"
+         << setw(12) << "Max (us)" << "\n";
+    cout << string(84, '-') << "\n";
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const OpSummary& summary = summaries[op];
+        cout << left << setw(16) << STAT_NAMES[op]
+             << right << setw(10) << summary.count
+             << setw(10) << setprecision(2) << summary.perSecond
+             << setprecision(1)
+             << setw(12) << summary.p50Us
+             << setw(12) << summary.p90Us
+             << setw(12) << summary.p99Us
+             << setw(12) << summary.maxUs << "\n";
+    }
+    cout << left;
+
+    cout << "\n1. Save as JSON (stats.json)\n"
+         << "2. Return\n";
+    if (getMenuChoice("Enter your choice: ", 1, 2) == 1) {
+        ofstream outFile("stats.json");
+        outFile << statsJson() << "\n";
+        cout << (outFile ? "Stats written to stats.json\n" : "Error writing stats.json\n");
+        cout << "\nPress Enter to return...";
+        cin.get();
+    }
+}
+
+void salesReports(BookingEngine& engine) {
+    const vector<Event>& eventlist = engine.eventlist;
+    const DataIndex& index = engine.index;
+    showScreenHeader("SALES REPORTS");
+    cout << "1. One event\n"
+         << "2. Events in a date range\n"
+         << "3. All events\n"
+         << "4. Return\n";
+    int scope = getMenuChoice("Enter your choice: ", 1, 4);
+    if (scope == 4) return;
+
+    vector<size_t> positions;
+    if (scope == 1) {
+        int eventId;
+        cout << "Enter Event ID: ";
+        cin >> eventId;
+        clearInput();
+        auto it = index.eventById.find(eventId);
+        if (it != index.eventById.end()) positions.push_back(it->second);
+    } else if (scope == 2) {
+        // Past events are what finance usually asks for, so no default start
+        int firstDay = numeric_limits<int>::min();
+        int lastDay = numeric_limits<int>::max();
+        string from = getlineinput("From date DD-MM-YYYY (blank for no limit): ");
+        string to = getlineinput("To date DD-MM-YYYY (blank for no limit): ");
+        // NO_DATE is also the lowest int, so only a typed date can be invalid
+        bool badDate = false;
+        if (!from.empty()) {
+            firstDay = dateToDayNumber(from);
+            badDate = firstDay == NO_DATE;
+        }
+        if (!to.empty()) {
+            lastDay = dateToDayNumber(to);
+            badDate = badDate || lastDay == NO_DATE;
+        }
+        if (badDate) {
+            cout << "Error: Date must be in DD-MM-YYYY format (e.g., 15-06-2025).\n";
+            cout << "\nPress Enter to return...";
+            cin.get();
+            return;
+        }
+        positions = index.eventsBetween(firstDay, lastDay);
+    } else {
+        positions.resize(eventlist.size());
+        for (size_t i = 0; i < positions.size(); i++) positions[i] = i;
+    }
+    if (positions.empty()) {
+        cout << "\nNo events to report on.\n";
+        cout << "\nPress Enter to return...";
+        cin.get();
+        return;
+    }
+
+    cout << "\n1. CSV\n"
+         << "2. JSON\n";
+    bool json = getMenuChoice("Choose a format: ", 1, 2) == 2;
+    string defaultName = json ? "sales_report.json" : "sales_report.csv";
+    string filename = getlineinput("File name (blank for " + defaultName + "): ");
+    if (filename.empty()) filename = defaultName;
+
+    auto start = chrono::steady_clock::now();
+    SalesReport report;
+    report.build(eventlist, positions, engine.reportSnapshot(positions));
+    bool written = exportSalesReport(report, filename, json);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (written) {
+        cout << "\nReport on " << report.events.size() << " event(s), " << report.tierCount()
+             << " tier(s) written to " << filename << " in " << fixed << setprecision(1) << ms << " ms\n";
+        cout << "Sold: " << report.overall.totals.tickets << " | Revenue: $" << setprecision(2)
+             << report.overall.totals.revenue() << "\n";
+    } else {
+        cout << "\nError writing " << filename << "\n";
+    }
+    cout << "\nPress Enter to return...";
+    cin.get();
+}
+
+void adminPanel(vector<Event>& eventlist, const vector<User>& Userlist, BookingEngine& engine) {
+    int choice;
+    do {
+        showScreenHeader("ADMIN PANEL");
+        cout << "1. Register New Event\n"
+             << "2. View All Events\n"
+             << "3. View All Users\n"
+             << "4. View All Bookings\n"
+             << "5. Return to Main Menu\n"
+             << "6. Operational Stats\n"
+             << "7. Sales Reports\n";
+        
+        choice = getMenuChoice("Enter your choice: ", 1, 7);
+
+        switch(choice) {
+            case 1: {
+                showScreenHeader("REGISTER NEW EVENT");
+                if (!engine.canAddEvents()) {
+                    cout << "Events can only be registered on the kiosk that writes the data files (process "
+                         << engine.ownerProcess() << ").\n";
+                    cout << "\nPress Enter to return...";
+                    cin.get();
+                    break;
+                }
+                int id = engine.newEventId();
+                cout << "Event ID: " << id << endl;
+
+                string name = getlineinput("Enter Event Name: ");
+                string location = getlineinput("Enter Event Location: ");
+
+                string date;
+                bool validDate = false;
+                do {
+                    date = getlineinput("Enter Event Date (DD-MM-YYYY): ");
+                } while (!validdate(date));
+
+                Event newEvent(id, name, location, date);
+                
+                while (true) {
+                    cout << "\nAdd Ticket Catagory (or 'done' to finish):\n";
+                    string tierName = getlineinput("Enter Catagory Name: ");
+                    if (tierName == "done") break;
+
+                    float price;
+                    cout << "Enter price for this catagory: $";
+                    while (!(cin >> price)) {
+                        cin.clear();
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                        cout << "Invalid input. Please enter a number: ";
+                    }
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+                    // Assigned seating: every seat in the layout is on sale
+                    int seatRows = 0, seatsPerRow = 0;
+                    while (true) {
+                        string layout = getlineinput("Seat layout ROWSxSEATS, e.g. 20x30 (blank for general admission): ");
+                        size_t x = layout.find('x');
+                        if (layout.empty() ||
+                            (x != string::npos && parseField(string_view(layout).substr(0, x), seatRows) &&
+                             parseField(string_view(layout).substr(x + 1), seatsPerRow) &&
+                             SeatMap::validLayout(seatRows, seatsPerRow))) {
+                            break;
+                        }
+                        seatRows = seatsPerRow = 0;
+                        cout << "Invalid layout. Please enter rows and seats per row like 20x30, at most "
+                             << SeatMap::MAX_SEATS << " seats in all.\n";
+                    }
+
+                    int quantity = seatRows * seatsPerRow;
+                    if (seatRows == 0) {
+                        cout << "Enter available quantity of tickets: ";
+                        while (!(cin >> quantity)) {
+                            cin.clear();
+                            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                            cout << "Invalid input. Please enter a number: ";
+                        }
+                        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    }
+
+                    if (!newEvent.addTicketTier(tierName, price, quantity, seatRows, seatsPerRow)) {
+                        cout << "The system already has too many ticket catagory names; reuse an existing name.\n";
+                    }
+                }
+
+                if (newEvent.ticketTiers.empty()) {
+                    cout << "\nAdding default ticket catagory...\n";
+                    float price;
+                    cout << "Enter default ticket price: $";
+                    cin >> price;
+                    clearInput();
+
+                    int quantity;
+                    cout << "Enter available quantity: ";
+                    cin >> quantity;
+                    clearInput();
+
+                    if (!newEvent.addTicketTier("Standard", price, quantity)) {
+                        cout << "\nThe system already has too many ticket catagory names; event not registered.\n";
+                        cout << "\nPress Enter to return...";
+                        cin.get();
+                        break;
+                    }
+                }
+
+                engine.addEvent(newEvent);
+                cout << "\nEvent registered successfully!\n";
+                cout << "\nPress Enter to return...";
+                cin.get();  // Wait for exactly one Enter press
+                break;
+            }
+            case 2:
+                displayAllEvents(eventlist);
+                break;
+            case 3:
+                displayAllUsers(Userlist);
+                break;
+            case 4:
+                viewAllBookingsAdmin(engine.snapshot(), Userlist, eventlist, engine.index);
+                break;
+            case 5:
+                return;
+            case 6:
+                viewOperationalStats();
+                break;
+            case 7:
+                salesReports(engine);
+                break;
+        }
+    } while (true);
+}
+
+void joinTierWaitlist(BookingEngine& engine, int userId, const Event& event, const TicketTier& tier) {
+    cout << "\n" << event.tierName(tier) << " tickets for " << event.eventName << " are sold out.\n";
+    cout << "Join the waitlist? If tickets are returned they are booked for you\n"
+         << "automatically, in the order customers joined. (Y/N): ";
+    char join;
+    cin >> join;
+    clearInput();
+    if (toupper(join) != 'Y') {
+        cout << "Returning to menu.\n";
+        waitForEnter();
+        return;
+    }
+
+    int quantity;
+    while (true) {
+        cout << "Number of tickets wanted: ";
+        cin >> quantity;
+        clearInput();
+        if (quantity <= 0) {
+            cout << "Please enter at least 1 ticket.\n";
+        } else if (tier.seats && quantity > tier.seats->seatsPerRow) {
+            cout << "Seats are booked side by side; at most " << tier.seats->seatsPerRow << " per booking.\n";
+        } else {
+            break;
+        }
+    }
+
+    int position;
+    BookResult result = engine.joinWaitlist(userId, event.eventID, event.tierName(tier), quantity, position);
+    if (result == BOOK_OK) {
+        cout << "\nYou are number " << position << " on the waitlist.\n";
+        cout << "Bookings made for you will appear in View My Bookings.\n";
+    } else if (result == BOOK_NOT_SOLD_OUT) {
+        cout << "\nTickets have just come back on sale - please book them instead.\n";
+    } else {
+        cout << "\nCould not join the waitlist.\n";
+    }
+    cout << "\nPress Enter to return...";
+    waitForEnter();
+}
+
+void userBookTicket(vector<Event>& eventlist, vector<User>& Userlist, BookingEngine& engine) {
+    showScreenHeader("BOOK TICKETS");
+    
+    if (eventlist.empty()) {
+        cout << "No events available for booking.\n";
+        waitForEnter();
+        return;
+    }
+    if (Userlist.empty()) {
+        cout << "No users registered. Please register first.\n";
+        waitForEnter();
+        return;
+    }
+
+    int UserId;
+    cout << "Enter User ID: ";
+    cin >> UserId;
+    clearInput();
+
+    if (!engine.index.findUser(Userlist, UserId)) {
+        cout << "User ID not found.\n";
+        waitForEnter();
+        return;
+    }
+
+    cout << "\n===== Available Events =====\n";
+    for (const auto& event : eventlist) {
+        cout << "ID: " << event.eventID << " | " << event.eventName 
+             << " (" << event.eventDate << " at " << event.eventLocation << ")";
+        if (event.getTotalTickets() <= 0) cout << " [Sold out - waitlist open]";
+        cout << "\n";
+    }
+
+    int eventID;
+    cout << "\nEnter Event ID to book: ";
+    cin >> eventID;
+    clearInput();
+
+    Event* eventPtr = engine.index.findEvent(eventlist, eventID);
+
+    if (!eventPtr) {
+        cout << "Event ID not found.\n";
+        waitForEnter();
+        return;
+    }
+
+    cout << "\n===== Available Ticket Tiers =====\n";
+    cout << "0. Go back\n";
+    vector<pair<string, const TicketTier*>> availableTiers;
+    int option = 1;
+    
+    // Sold-out tiers stay on the list so buyers can join their waitlist
+    for (const auto& tier : eventPtr->ticketTiers) {
+        int available = tier.available();
+        cout << option << ". " << eventPtr->tierName(tier) << " - $" << fixed << setprecision(2) << tier.price;
+        if (available > 0) {
+            cout << " (" << available << " available)\n";
+        } else {
+            cout << " (sold out, " << engine.waitlistLength(eventID, tier.nameId)
+                 << " waiting - join waitlist)\n";
+        }
+        availableTiers.emplace_back(eventPtr->tierName(tier), &tier);
+        option++;
+    }
+
+    if (availableTiers.empty()) {
+        cout << "No ticket tiers available.\n";
+        waitForEnter();
+        return;
+    }
+
+    int tierChoice = getMenuChoice(
+        "\nSelect ticket tier (0-" + to_string(availableTiers.size()) + "): ", 
+        0, 
+        availableTiers.size()
+    );
+    
+    if (tierChoice == 0) {
+        cout << "Returning to menu.\n";
+        waitForEnter();
+        return;
+    }
+
+    const auto& selectedTier = availableTiers[tierChoice-1];
+    string tierName = selectedTier.first;
+    float tierPrice = selectedTier.second->price;
+    int tierAvailable = selectedTier.second->available();
+    const SeatMap* seatMap = selectedTier.second->seats.get();
+
+    if (tierAvailable <= 0) {
+        joinTierWaitlist(engine, UserId, *eventPtr, *selectedTier.second);
+        return;
+    }
+
+    int ticketQuantity;
+    while (true) {
+        cout << "Number of tickets to book: ";
+        cin >> ticketQuantity;
+        clearInput();
+        
+        if (ticketQuantity <= 0) {
+            cout << "Please enter at least 1 ticket.\n";
+        } else if (ticketQuantity > tierAvailable) {
+            cout << "Only " << tierAvailable << " tickets available.\n";
+        } else if (seatMap && ticketQuantity > seatMap->seatsPerRow) {
+            cout << "Seats are booked side by side; at most " << seatMap->seatsPerRow << " per booking.\n";
+        } else {
+            break;
+        }
+    }
+
+    // Hold the tickets while the buyer decides so they cannot be sold
+    // to someone else in the meantime
+    SeatHold seatHold;
+    BookResult held = engine.hold(UserId, eventID, tierName, ticketQuantity, seatHold);
+    if (held != BOOK_OK) {
+        if (held == BOOK_NO_ADJACENT_SEATS) {
+            cout << "\nSorry, there are no longer " << ticketQuantity
+                 << " seats together in this tier. Booking not made.\n";
+        } else {
+            cout << "\nSorry, only " << selectedTier.second->available()
+                 << " tickets are left in this tier now. Booking not made.\n";
+        }
+        cout << "\nPress Enter to return...";
+        waitForEnter();
+        return;
+    }
+
+    float totalPrice = ticketQuantity * tierPrice;
+
+    cout << "\n===== Booking Summary =====\n";
+    cout << "Event: " << eventPtr->eventName << endl;
+    cout << "Date: " << eventPtr->eventDate << endl;
+    cout << "Location: " << eventPtr->eventLocation << endl;
+    cout << "Ticket Tier: " << tierName << endl;
+    cout << "Quantity: " << ticketQuantity << endl;
+    if (seatMap) cout << "Seats: " << seatMap->label(seatHold.seatId, ticketQuantity) << endl;
+    cout << "Price per Ticket: $" << fixed << setprecision(2) << tierPrice << endl;
+    cout << "Total Price: $" << fixed << setprecision(2) << totalPrice << endl;
+    cout << "\nYour tickets are held for " << DEFAULT_HOLD_SECONDS / 60 << " minutes.\n";
+
+    char confirm;
+    do {
+        cout << "\nConfirm booking? (Y/N): ";
+        cin >> confirm;
+        confirm = toupper(confirm);
+        
+    } while (confirm != 'Y' && confirm != 'N');
+
+    if (confirm == 'Y') {
+        int bookingId;
+        if (engine.confirmHold(seatHold.holdId, bookingId) == BOOK_OK) {
+            cout << "\nBooking confirmed!\n";
+            cout << "Booking ID: " << bookingId << endl;
+        } else {
+            cout << "\nSorry, your hold expired and the tickets were released. Booking not made.\n";
+        }
+    } else {
+        engine.releaseHold(seatHold.holdId);
+        cout << "Booking cancelled.\n";
+    }
+    cout << "\nPress Enter to return...";
+    waitForEnter();
+}
+
+void cancelBooking(vector<Booking>& bookings, BookingEngine& engine) {
+    showScreenHeader("CANCEL BOOKING");
+    
+    if (bookings.empty()) {
+        cout << "No bookings to cancel.\n";
+        waitForEnter();
+        return;
+    }
+
+    int bookingId;
+    cout << "Enter Booking ID to cancel: ";
+    cin >> bookingId;
+
+    Booking booking(0, 0, 0, 0, 0, 0);
+    vector<int> promoted;
+    bool found = engine.cancel(bookingId, &booking, &promoted);
+    if (found) {
+        cout << "\n===== Cancellation Summary =====\n";
+        cout << "Booking ID: " << booking.bookingId << " cancelled\n";
+        cout << booking.tickets << " tickets released\n";
+        if (!promoted.empty()) {
+            cout << "Booked for " << promoted.size() << " customer(s) on the waitlist (Booking IDs:";
+            for (int promotedId : promoted) cout << " " << promotedId;
+            cout << ")\n";
+        }
+    }
+
+    if (!found) {
+        cout << "Booking not found or already cancelled.\n";
+    }
+    cout << "\nPress Enter to return...";
+    waitForEnter();
+}
+
+void viewUserBookings(BookingEngine& engine, const vector<User>& Userlist, const vector<Event>& eventlist, const DataIndex& index) {
+    showScreenHeader("MY BOOKINGS");
+    
+    if (engine.snapshot().empty()) {
+        cout << "No bookings found.\n";
+        cout << "\nPress Enter to return...";
+        waitForEnter();
+        return;
+    }
+
+    int userId;
+    cout << "Enter your User ID: ";
+    cin >> userId;
+    BookingSnapshot bookings = engine.userSnapshot(userId);
+
+    // Find user
+    const User* user = index.findUser(Userlist, userId);
+    string userName = user ? user->UserName : "No user found with this id";
+
+    cout << "\nUser: " << userName << " (ID: " << userId << ")\n\n";
+    
+    // Table header
+    cout << left << setw(12) << "Booking ID" 
+         << setw(15) << "Status" 
+         << setw(15) << "Event" 
+         << setw(12) << "Date" 
+         << setw(15) << "Location" 
+         << setw(12) << "Tier" 
+         << setw(8) << "Tickets" 
+         << setw(12) << "Total Price" 
+         << "Seats"
+         << endl;
+
+    cout << string(117, '-') << endl;
+
+    bool hasBookings = false;
+    for (size_t pos : bookings.userRows) {
+        const Booking& booking = bookings[pos];
+        hasBookings = true;
+
+        // Find event details
+        const Event* event = index.findEvent(eventlist, booking.eventId);
+        string eventName = event ? event->eventName : "Unknown";
+        string eventDate = event ? event->eventDate : "Unknown";
+        string eventLocation = event ? event->eventLocation : "Unknown";
+        const TicketTier* tier = event ? event->findTier(booking.tierId) : nullptr;
+        string seats = tier && tier->seats && booking.seatId >= 0
+            ? tier->seats->label(booking.seatId, booking.tickets) : "-";
+
+        cout << left << setw(12) << booking.bookingId 
+             << setw(15) << statusName(booking.status) 
+             << setw(15) << eventName 
+             << setw(12) << eventDate 
+             << setw(15) << eventLocation 
+             << setw(12) << (event ? event->tierName(booking.tierId) : "Unknown") 
+             << setw(8) << booking.tickets 
+             << "$" << fixed << setprecision(2) << setw(11) << booking.totalPrice 
+             << seats
+             << endl;
+    }
+
+    if (!hasBookings) {
+        cout << "No bookings found for User ID: " << userId << endl;
+    }
+    cout << "\nPress Enter to return...";
+    waitForEnter();
+}
+
+void findEventsByDate(const vector<Event>& eventlist, const DataIndex& index) {
+    showScreenHeader("FIND EVENTS BY DATE");
+
+    int firstDay = todayDayNumber();
+    int lastDay = numeric_limits<int>::max();
+
+    string from = getlineinput("From date DD-MM-YYYY (blank for today): ");
+    if (!from.empty()) {
+        firstDay = dateToDayNumber(from);
+        if (firstDay == NO_DATE) {
+            cout << "Error: Date must be in DD-MM-YYYY format (e.g., 15-06-2025).\n";
+            cout << "\nPress Enter to return...";
+            cin.get();
+            return;
+        }
+    }
+    string to = getlineinput("To date DD-MM-YYYY (blank for no limit): ");
+    if (!to.empty()) {
+        lastDay = dateToDayNumber(to);
+        if (lastDay == NO_DATE) {
+            cout << "Error: Date must be in DD-MM-YYYY format (e.g., 15-06-2025).\n";
+            cout << "\nPress Enter to return...";
+            cin.get();
+            return;
+        }
+    }
+
+    vector<size_t> found = index.eventsBetween(firstDay, lastDay);
+    if (found.empty()) {
+        cout << "\nNo events found in that date range.\n";
+        cout << "\nPress Enter to return...";
+        cin.get();
+        return;
+    }
+
+    cout << "\n" << left << setw(6) << "ID"
+         << setw(30) << "EVENT NAME"
+         << setw(26) << "LOCATION"
+         << setw(14) << "DATE"
+         << "TICKETS AVAILABLE\n"
+         << string(92, '-') << "\n";
+    for (size_t pos : found) {
+        const Event& event = eventlist[pos];
+        cout << left << setw(6) << event.eventID
+             << setw(30) << (event.eventName.length() > 24 ? event.eventName.substr(0, 21) + "..." : event.eventName)
+             << setw(26) << (event.eventLocation.length() > 19 ? event.eventLocation.substr(0, 16) + "..." : event.eventLocation)
+             << setw(14) << event.eventDate
+             << event.getTotalTickets() << "\n";
+    }
+    cout << "\n" << found.size() << " event(s) found.\n";
+    cout << "\nPress Enter to return...";
+    cin.get();
+}
+
+void searchEvents(const vector<Event>& eventlist, const DataIndex& index) {
+    const size_t PAGE_SIZE = 10;
+    showScreenHeader("SEARCH EVENTS");
+
+    string query = getlineinput("Search event names and locations (start of a word is enough): ");
+    vector<SearchHit> hits = index.search.search(query);
+    if (hits.empty()) {
+        cout << "\nNo events match \"" << query << "\".\n";
+        cout << "\nPress Enter to return...";
+        cin.get();
+        return;
+    }
+
+    size_t page = 0;
+    size_t pages = (hits.size() + PAGE_SIZE - 1) / PAGE_SIZE;
+    while (true) {
+        showScreenHeader("SEARCH EVENTS");
+        cout << hits.size() << " event(s) match \"" << query << "\" - page "
+             << page + 1 << " of " << pages << "\n\n";
+        cout << left << setw(6) << "ID"
+             << setw(30) << "EVENT NAME"
+             << setw(26) << "LOCATION"
+             << setw(14) << "DATE"
+             << "TICKETS AVAILABLE\n"
+             << string(92, '-') << "\n";
+        for (size_t i = page * PAGE_SIZE; i < min(hits.size(), (page + 1) * PAGE_SIZE); i++) {
+            const Event& event = eventlist[hits[i].eventPos];
+            cout << left << setw(6) << event.eventID
+                 << setw(30) << (event.eventName.length() > 24 ? event.eventName.substr(0, 21) + "..." : event.eventName)
+                 << setw(26) << (event.eventLocation.length() > 19 ? event.eventLocation.substr(0, 16) + "..." : event.eventLocation)
+                 << setw(14) << event.eventDate
+                 << event.getTotalTickets() << "\n";
+        }
+
+        string move = getlineinput("\nN = next page, P = previous page, Enter to return: ");
+        if (move == "n" || move == "N") {
+            if (page + 1 < pages) page++;
+        } else if (move == "p" || move == "P") {
+            if (page > 0) page--;
+        } else {
+            return;
+        }
+    }
+}
+
+// =============== SCRIPTED MODE ===============
+// Run with: event-ticket-system --script [file]   (stdin if no file or "-")
+// Reads one comma-separated command per line and runs it through the
+// BookingEngine, like the menus do, without any prompts:
+//   register,<name>
+//   create-event,<name>,<location>,<DD-MM-YYYY>,<tier>:<price>:<quantity>[@<rows>x<seats>],...
+//   book,<userId>,<eventId>,<tier>,<quantity>
+//   cancel,<bookingId>        (OK,cancel,<bookingId>,<tickets>[,<waitlist bookingId>...])
+//   waitlist,<userId>,<eventId>,<tier>,<quantity>   (OK,waitlist,<place in queue>)
+//   hold,<userId>,<eventId>,<tier>,<quantity>[,<seconds>]
+//   confirm,<holdId>
+//   release,<holdId>
+//   list-events
+//   search,<words>[,<offset>[,<limit>]]
+//   user-bookings,<userId>
+//   event-sales,<eventId>
+//   availability,<eventId>
+//   stats                     (OK,stats,<operational stats as JSON>)
+//   sales-report,<csv|json>,<file>[,<eventId>|,<from>,<to>]
+//                             (OK,sales-report,<events>,<tiers>; all events
+//                             unless one event or a date range is given.
+//                             file is a bare name, written under reports/)
+// Blank lines and lines starting with '#' are skipped. Each command writes
+// one result line, "OK,<command>,..." or "ERR,<command>,<reason>"; only
+// list-events and search follow their OK line with one "event,..." line
+// per event.
+// In tiers with assigned seating, book, hold and confirm results end with
+// the id of the first of the adjacent seats.
+// A throughput summary goes to stderr at the end.
+const char* bookResultCode(BookResult result) {
+    switch (result) {
+        case BOOK_OK: return "OK";
+        case BOOK_UNKNOWN_USER: return "UNKNOWN_USER";
+        case BOOK_UNKNOWN_EVENT: return "UNKNOWN_EVENT";
+        case BOOK_UNKNOWN_TIER: return "UNKNOWN_TIER";
+        case BOOK_INVALID_QUANTITY: return "INVALID_QUANTITY";
+        case BOOK_SOLD_OUT: return "SOLD_OUT";
+        case BOOK_NO_HOLD: return "NO_HOLD";
+        case BOOK_NO_ADJACENT_SEATS: return "NO_ADJACENT_SEATS";
+        case BOOK_NOT_SOLD_OUT: return "NOT_SOLD_OUT";
+    }
+    return "UNKNOWN";
+}
+
+// Runs commands for the script and server modes. Safe to call from several
+// threads: bookings, cancellations and queries share modelMutex, while
+// register and create-event (which grow the user and event lists) hold it
+// exclusively, as BookingEngine requires.
+class CommandHandler {
+public:
+    BookingEngine& engine;
+    shared_mutex modelMutex;
+    bool usersChanged = false;
+
+    CommandHandler(BookingEngine& bookingEngine) : engine(bookingEngine) {}
+
+    // Returns false if the command failed (an ERR line was written). A
+    // command that throws is answered with INTERNAL rather than taking the
+    // script or server down with it.
+    bool execute(const vector<string_view>& fields, ostream& out) {
+        try {
+            return run(fields, out);
+        } catch (const exception&) {
+            return error(fields[0], "INTERNAL", out);
+        }
+    }
+
+    // Lets expired holds go back on sale while no commands are arriving, and
+    // picks up what other processes sharing the inventory have done. Only
+    // catching up can grow the user and event lists; expiry alone runs
+    // alongside other commands.
+    void tick() {
+        if (engine.shared) {
+            unique_lock<shared_mutex> lock(modelMutex);
+            engine.syncShared();
+            engine.expireHolds();
+        } else {
+            shared_lock<shared_mutex> lock(modelMutex);
+            engine.expireHolds();
+        }
+    }
+
+    // Users are written once here; bookings are already journaled. So are
+    // users when sharing the inventory.
+    void finish() {
+        unique_lock<shared_mutex> lock(modelMutex);
+        if (usersChanged && !engine.shared) saveUsers(engine.Userlist);
+        usersChanged = false;
+        engine.checkpoint();
+    }
+
+private:
+    bool run(const vector<string_view>& fields, ostream& out) {
+        string_view command = fields[0];
+        if (command == "register") return registerUser(fields, out);
+        if (command == "create-event") return createEvent(fields, out);
+        if (command == "book") return book(fields, out);
+        if (command == "cancel") return cancel(fields, out);
+        if (command == "waitlist") return waitlist(fields, out);
+        if (command == "hold") return hold(fields, out);
+        if (command == "confirm") return confirm(fields, out);
+        if (command == "release") return release(fields, out);
+        if (command == "list-events") return listEvents(fields, out);
+        if (command == "search") return search(fields, out);
+        if (command == "user-bookings") return userBookings(fields, out);
+        if (command == "event-sales") return eventSales(fields, out);
+        if (command == "availability") return availability(fields, out);
+        if (command == "stats") return stats(fields, out);
+        if (command == "sales-report") return salesReport(fields, out);
+        return error(command, "UNKNOWN_COMMAND", out);
+    }
+
+    bool error(string_view command, const char* reason, ostream& out) {
+        out << "ERR," << command << ',' << reason << '\n';
+        return false;
+    }
+
+    bool registerUser(const vector<string_view>& fields, ostream& out) {
+        if (fields.size() != 2 || fields[1].empty()) return error(fields[0], "BAD_ARGUMENTS", out);
+        unique_lock<shared_mutex> lock(modelMutex);
+        int userId = engine.newUserId();
+        engine.addUser(User(userId, string(fields[1])));
+        usersChanged = true;
+        out << "OK,register," << userId << '\n';
+        return true;
+    }
+
+    bool createEvent(const vector<string_view>& fields, ostream& out) {
+        if (fields.size() < 5) return error(fields[0], "BAD_ARGUMENTS", out);
+        // The admin screen's rules, as for imported events
+        if (const char* problem = dateProblem(fields[3])) return error(fields[0], problem, out);
+
+        Event event(0, string(fields[1]), string(fields[2]), string(fields[3]));
+        for (size_t i = 4; i < fields.size(); i++) {
+            if (const char* problem = parseTier(fields[i], event)) return error(fields[0], problem, out);
+        }
+
+        unique_lock<shared_mutex> lock(modelMutex);
+        event.eventID = engine.newEventId();
+        if (!engine.addEvent(event)) return error(fields[0], "NOT_OWNER", out);
+        out << "OK,create-event," << event.eventID << '\n';
+        return true;
+    }
+
+    bool book(const vector<string_view>& fields, ostream& out) {
+        int userId, eventId, quantity;
+        if (fields.size() != 5 || !parseField(fields[1], userId) || !parseField(fields[2], eventId) ||
+            !parseField(fields[4], quantity)) {
+            return error(fields[0], "BAD_ARGUMENTS", out);
+        }
+        shared_lock<shared_mutex> lock(modelMutex);
+        int bookingId;
+        BookResult result = engine.book(userId, eventId, string(fields[3]), quantity, bookingId);
+        if (result != BOOK_OK) return error(fields[0], bookResultCode(result), out);
+
+        out << "OK,book,";
+        writeBooking(bookingId, out);
+        return true;
+    }
+
+    bool cancel(const vector<string_view>& fields, ostream& out) {
+        int bookingId;
+        if (fields.size() != 2 || !parseField(fields[1], bookingId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        Booking cancelled(0, 0, 0, 0, 0, 0);
+        vector<int> promoted;
+        if (!engine.cancel(bookingId, &cancelled, &promoted)) return error(fields[0], "NOT_FOUND", out);
+
+        out << "OK,cancel," << bookingId << ',' << cancelled.tickets;
+        for (int promotedId : promoted) out << ',' << promotedId;
+        out << '\n';
+        return true;
+    }
+
+    bool waitlist(const vector<string_view>& fields, ostream& out) {
+        int userId, eventId, quantity;
+        if (fields.size() != 5 || !parseField(fields[1], userId) || !parseField(fields[2], eventId) ||
+            !parseField(fields[4], quantity)) {
+            return error(fields[0], "BAD_ARGUMENTS", out);
+        }
+        shared_lock<shared_mutex> lock(modelMutex);
+        int position;
+        BookResult result = engine.joinWaitlist(userId, eventId, string(fields[3]), quantity, position);
+        if (result != BOOK_OK) return error(fields[0], bookResultCode(result), out);
+
+        out << "OK,waitlist," << position << '\n';
+        return true;
+    }
+
+    // OK,hold,<holdId>,<totalPrice>,<seconds>[,<firstSeat>]
+    bool hold(const vector<string_view>& fields, ostream& out) {
+        int userId, eventId, quantity;
+        int seconds = DEFAULT_HOLD_SECONDS;
+        if ((fields.size() != 5 && fields.size() != 6) || !parseField(fields[1], userId) ||
+            !parseField(fields[2], eventId) || !parseField(fields[4], quantity) ||
+            (fields.size() == 6 && (!parseField(fields[5], seconds) || seconds <= 0 || seconds > MAX_HOLD_SECONDS))) {
+            return error(fields[0], "BAD_ARGUMENTS", out);
+        }
+        shared_lock<shared_mutex> lock(modelMutex);
+        SeatHold seatHold;
+        BookResult result = engine.hold(userId, eventId, string(fields[3]), quantity, seatHold, seconds);
+        if (result != BOOK_OK) return error(fields[0], bookResultCode(result), out);
+
+        out << "OK,hold," << seatHold.holdId << ',' << fixed << setprecision(2) << seatHold.totalPrice
+            << ',' << seconds;
+        if (seatHold.seatId >= 0) out << ',' << seatHold.seatId;
+        out << '\n';
+        return true;
+    }
+
+    // OK,confirm,<holdId>,<bookingId>,<totalPrice>[,<firstSeat>]
+    bool confirm(const vector<string_view>& fields, ostream& out) {
+        int holdId;
+        if (fields.size() != 2 || !parseField(fields[1], holdId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        int bookingId;
+        BookResult result = engine.confirmHold(holdId, bookingId);
+        if (result != BOOK_OK) return error(fields[0], bookResultCode(result), out);
+
+        out << "OK,confirm," << holdId << ',';
+        writeBooking(bookingId, out);
+        return true;
+    }
+
+    bool release(const vector<string_view>& fields, ostream& out) {
+        int holdId;
+        if (fields.size() != 2 || !parseField(fields[1], holdId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        if (!engine.releaseHold(holdId)) return error(fields[0], "NO_HOLD", out);
+
+        out << "OK,release," << holdId << '\n';
+        return true;
+    }
+
+    // OK,list-events,<count> then event,<id>,<name>,<location>,<date>,<available>
+    bool listEvents(const vector<string_view>& fields, ostream& out) {
+        if (fields.size() != 1) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        engine.expireHolds();
+        out << "OK,list-events," << engine.eventlist.size() << '\n';
+        for (const auto& event : engine.eventlist) writeEvent(event, out);
+        return true;
+    }
+
+    // OK,search,<total matches>,<count> then <count> event lines as for
+    // list-events, best match first. Default page: offset 0, limit 20.
+    bool search(const vector<string_view>& fields, ostream& out) {
+        size_t offset = 0, limit = 20;
+        if (fields.size() < 2 || fields.size() > 4 ||
+            (fields.size() > 2 && !parseField(fields[2], offset)) ||
+            (fields.size() > 3 && !parseField(fields[3], limit))) {
+            return error(fields[0], "BAD_ARGUMENTS", out);
+        }
+        shared_lock<shared_mutex> lock(modelMutex);
+        vector<SearchHit> hits = engine.index.search.search(fields[1]);
+        size_t first = min(offset, hits.size());
+        size_t last = min(hits.size(), first + limit);
+        out << "OK,search," << hits.size() << ',' << last - first << '\n';
+        for (size_t i = first; i < last; i++) writeEvent(engine.eventlist[hits[i].eventPos], out);
+        return true;
+    }
+
+    // OK,user-bookings,<userId>,<confirmed>,<cancelled>,<tickets>,<revenue>
+    bool userBookings(const vector<string_view>& fields, ostream& out) {
+        int userId;
+        if (fields.size() != 2 || !parseField(fields[1], userId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        if (!engine.index.findUser(engine.Userlist, userId)) return error(fields[0], "UNKNOWN_USER", out);
+
+        lock_guard<mutex> bookingsLock(engine.bookingsMutex);
+        writeTotals("user-bookings", userId, engine.totals->forUser(userId), out);
+        return true;
+    }
+
+    // OK,event-sales,<eventId>,<confirmed>,<cancelled>,<tickets>,<revenue>
+    bool eventSales(const vector<string_view>& fields, ostream& out) {
+        int eventId;
+        if (fields.size() != 2 || !parseField(fields[1], eventId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        if (!engine.index.findEvent(engine.eventlist, eventId)) return error(fields[0], "UNKNOWN_EVENT", out);
+
+        lock_guard<mutex> bookingsLock(engine.bookingsMutex);
+        writeTotals("event-sales", eventId, engine.totals->forEvent(eventId), out);
+        return true;
+    }
+
+    // OK,availability,<eventId>,<tier>:<price>:<remaining>,...
+    bool availability(const vector<string_view>& fields, ostream& out) {
+        int eventId;
+        if (fields.size() != 2 || !parseField(fields[1], eventId)) return error(fields[0], "BAD_ARGUMENTS", out);
+        shared_lock<shared_mutex> lock(modelMutex);
+        engine.expireHolds();
+        const Event* event = engine.index.findEvent(engine.eventlist, eventId);
+        if (!event) return error(fields[0], "UNKNOWN_EVENT", out);
+
+        out << "OK,availability," << eventId;
+        for (const auto& tier : event->ticketTiers) {
+            out << ',' << event->tierName(tier) << ':' << fixed << setprecision(2) << tier.price
+                << ':' << tier.available();
+        }
+        out << '\n';
+        return true;
+    }
+
+    bool stats(const vector<string_view>& fields, ostream& out) {
+        if (fields.size() != 1) return error(fields[0], "BAD_ARGUMENTS", out);
+        out << "OK,stats," << statsJson() << '\n';
+        return true;
+    }
+
+    bool salesReport(const vector<string_view>& fields, ostream& out) {
+        if (fields.size() < 3 || fields.size() > 5 || (fields[1] != "csv" && fields[1] != "json")) {
+            return error(fields[0], "BAD_ARGUMENTS", out);
+        }
+        // Server clients name the file, so it may not leave reports/
+        string_view name = fields[2];
+        if (name.empty() || name == "." || name == ".." || name.find_first_of("/\\:") != string_view::npos) {
+            return error(fields[0], "BAD_FILE_NAME", out);
+        }
+        shared_lock<shared_mutex> lock(modelMutex);
+        vector<size_t> positions;
+        if (fields.size() == 4) {
+            int eventId;
+            if (!parseField(fields[3], eventId)) return error(fields[0], "BAD_ARGUMENTS", out);
+            auto it = engine.index.eventById.find(eventId);
+            if (it == engine.index.eventById.end()) return error(fields[0], "UNKNOWN_EVENT", out);
+            positions.push_back(it->second);
+        } else if (fields.size() == 5) {
+            int firstDay = dateToDayNumber(fields[3]);
+            int lastDay = dateToDayNumber(fields[4]);
+            if (firstDay == NO_DATE || lastDay == NO_DATE) return error(fields[0], "BAD_DATE", out);
+            positions = engine.index.eventsBetween(firstDay, lastDay);
+        } else {
+            positions.resize(engine.eventlist.size());
+            for (size_t i = 0; i < positions.size(); i++) positions[i] = i;
+        }
+
+        // Built from a snapshot, so sales carry on while it is built
+        SalesReport report;
+        report.build(engine.eventlist, positions, engine.reportSnapshot(positions));
+        makeDirectory(REPORTS_DIRECTORY);
+        if (!exportSalesReport(report, REPORTS_DIRECTORY + "/" + string(name), fields[1] == "json")) {
+            return error(fields[0], "WRITE_FAILED", out);
+        }
+        out << "OK,sales-report," << report.events.size() << ',' << report.tierCount() << '\n';
+        return true;
+    }
+
+    void writeEvent(const Event& event, ostream& out) {
+        out << "event," << event.eventID << ',' << event.eventName << ',' << event.eventLocation
+            << ',' << event.eventDate << ',' << event.getTotalTickets() << '\n';
+    }
+
+    // <bookingId>,<totalPrice>[,<firstSeat>] for a booking just made
+    void writeBooking(int bookingId, ostream& out) {
+        float totalPrice;
+        int seatId;
+        {
+            lock_guard<mutex> bookingsLock(engine.bookingsMutex);
+            const Booking* booking = engine.index.findBooking(engine.bookings, bookingId);
+            totalPrice = booking->totalPrice;
+            seatId = booking->seatId;
+        }
+        out << bookingId << ',' << fixed << setprecision(2) << totalPrice;
+        if (seatId >= 0) out << ',' << seatId;
+        out << '\n';
+    }
+
+    void writeTotals(const char* command, int id, const SalesTotals& totals, ostream& out) {
+        out << "OK," << command << ',' << id << ',' << totals.confirmed << ','
+            << totals.cancelled << ',' << totals.tickets << ','
+            << fixed << setprecision(2) << totals.revenue() << '\n';
+    }
+};
+
+int runScript(BookingEngine& engine, const string& filename) {
+    ifstream file;
+    if (filename != "-") {
+        file.open(filename);
+        if (!file) {
+            cerr << "Error opening script " << filename << "\n";
+            return 1;
+        }
+    }
+    istream& in = filename == "-" ? cin : file;
+
+    ios::sync_with_stdio(false);
+    CommandHandler handler(engine);
+    size_t commands = 0;
+    size_t failed = 0;
+    auto start = chrono::steady_clock::now();
+
+    string line;
+    vector<string_view> fields;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        splitFields(line, fields);
+        commands++;
+        if (!handler.execute(fields, cout)) failed++;
+        if (commands % 256 == 0) handler.tick();
+    }
+    handler.finish();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout.flush();
+
+    cerr << "SUMMARY,commands=" << commands
+         << ",ok=" << commands - failed
+         << ",failed=" << failed
+         << ",seconds=" << fixed << setprecision(3) << seconds
+         << ",commands_per_sec=" << setprecision(0)
+         << (seconds > 0 ? commands / seconds : 0) << "\n";
+    return 0;
+}
+
+// =============== BULK IMPORT ===============
+// Run with: event-ticket-system --import <kind> <file> [<kind> <file>...]
+// kind is users, events or bookings, and each row has the layout of a line
+// of users.txt, events.txt or bookings.txt. Files are imported in the order
+// given, so list users, then events, then bookings.
+//
+// Each file is cut into chunks at line boundaries, and the chunks are parsed
+// and checked on all cores at once: the format, the validdate rules for
+// event dates, and for bookings that the user, event and tier exist. The
+// rows that pass are then merged on one thread in file order, which is where
+// ids already in use are caught. Rejected rows are written to
+// <file>.errors as <line>,<reason>,<row> and the import carries on; the data
+// files are written once at the end.
+//
+// Event rows give the tickets still on sale, as events.txt does, so
+// imported bookings do not take tickets from their tier. Confirmed bookings
+// in a seated tier do claim their seats.
+class ImportError {
+public:
+    size_t line;  // within the chunk until written out
+    const char* reason;
+    string_view row;
+};
+
+// A piece of the input file and what parsing it produced
+template <typename Row>
+class ImportChunk {
+public:
+    string_view text;
+    size_t lineCount = 0;
+    vector<Row> rows;
+    vector<size_t> rowLines;
+    vector<string_view> rowText;
+    vector<ImportError> errors;
+};
+
+class ImportReport {
+public:
+    size_t imported = 0;
+    size_t rejected = 0;
+};
+
+// Pieces of about chunkSize bytes, each ending at the end of a line
+vector<string_view> splitChunks(string_view data, size_t chunkSize) {
+    vector<string_view> chunks;
+    size_t start = 0;
+    while (start < data.size()) {
+        size_t end = start + chunkSize < data.size() ? data.find('\n', start + chunkSize) : string_view::npos;
+        end = end == string_view::npos ? data.size() : end + 1;
+        chunks.push_back(data.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+// parse(fields, rows) checks one row and appends it to rows, returning
+// nullptr, or returns why the row is rejected. It runs on several threads
+// at once, so it may only read shared data. merge(row) then runs on this
+// thread in file order and returns nullptr once the row is stored, or why
+// it was not.
+template <typename Row, typename Parse, typename Merge>
+ImportReport importFile(const string& filename, Parse parse, Merge merge) {
+    MappedFile file(filename);
+    unsigned workerCount = max(1u, thread::hardware_concurrency());
+    // Several chunks per worker so one slow chunk does not hold up the rest
+    size_t chunkSize = max<size_t>(1 << 20, file.data.size() / (workerCount * 8) + 1);
+    vector<ImportChunk<Row>> chunks;
+    for (string_view text : splitChunks(file.data, chunkSize)) {
+        chunks.emplace_back().text = text;
+    }
+
+    atomic<size_t> nextChunk(0);
+    auto parseChunks = [&]() {
+        vector<string_view> fields;
+        for (size_t c = nextChunk++; c < chunks.size(); c = nextChunk++) {
+            ImportChunk<Row>& chunk = chunks[c];
+            size_t pos = 0;
+            while (pos < chunk.text.size()) {
+                size_t end = chunk.text.find('\n', pos);
+                if (end == string_view::npos) end = chunk.text.size();
+                string_view line = chunk.text.substr(pos, end - pos);
+                pos = end + 1;
+                chunk.lineCount++;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                if (line.empty() || line[0] == '#') continue;
+
+                splitFields(line, fields);
+                if (const char* reason = parse(fields, chunk.rows)) {
+                    chunk.errors.push_back({chunk.lineCount, reason, line});
+                } else {
+                    chunk.rowLines.push_back(chunk.lineCount);
+                    chunk.rowText.push_back(line);
+                }
+            }
+        }
+    };
+    vector<thread> workers;
+    for (size_t i = 1; i < min<size_t>(workerCount, chunks.size()); i++) {
+        workers.emplace_back(parseChunks);
+    }
+    parseChunks();
+    for (auto& worker : workers) worker.join();
+
+    ImportReport report;
+    ofstream errorFile(filename + ".errors");
+    if (!errorFile) cerr << "Error creating " << filename << ".errors\n";
+    size_t linesBefore = 0;
+    for (auto& chunk : chunks) {
+        for (size_t i = 0; i < chunk.rows.size(); i++) {
+            if (const char* reason = merge(chunk.rows[i])) {
+                chunk.errors.push_back({chunk.rowLines[i], reason, chunk.rowText[i]});
+            } else {
+                report.imported++;
+            }
+        }
+        stable_sort(chunk.errors.begin(), chunk.errors.end(),
+                    [](const ImportError& a, const ImportError& b) { return a.line < b.line; });
+        for (const auto& error : chunk.errors) {
+            errorFile << linesBefore + error.line << ',' << error.reason << ',' << error.row << '\n';
+        }
+        report.rejected += chunk.errors.size();
+        linesBefore += chunk.lineCount;
+        chunk = ImportChunk<Row>();  // merged; free the rows
+    }
+    return report;
+}
+
+ImportReport importUsers(BookingEngine& engine, const string& filename) {
+    return importFile<User>(filename,
+        [](const vector<string_view>& fields, vector<User>& rows) -> const char* {
+            int id;
+            if (fields.size() < 2) return "BAD_FIELD_COUNT";
+            if (!parseField(fields[0], id) || id <= 0) return "BAD_ID";
+            // As in users.txt, the name is everything after the first comma
+            string_view name(fields[1].data(), fields.back().data() + fields.back().size() - fields[1].data());
+            if (name.empty()) return "NO_NAME";
+            rows.emplace_back(id, string(name));
+            return nullptr;
+        },
+        [&](User& user) -> const char* {
+            if (engine.index.userById.count(user.UserId)) return "DUPLICATE_ID";
+            engine.Userlist.push_back(move(user));
+            engine.index.addUser(engine.Userlist, engine.Userlist.size() - 1);
+            return nullptr;
+        });
+}
+
+ImportReport importEvents(BookingEngine& engine, const string& filename) {
+    return importFile<Event>(filename,
+        [](const vector<string_view>& fields, vector<Event>& rows) -> const char* {
+            int id;
+            if (fields.size() < 4) return "BAD_FIELD_COUNT";
+            if (!parseField(fields[0], id) || id <= 0) return "BAD_ID";
+            if (fields[1].empty()) return "NO_NAME";
+            if (const char* problem = dateProblem(fields[3])) return problem;
+
+            Event& event = rows.emplace_back(id, string(fields[1]), string(fields[2]), string(fields[3]));
+            for (size_t i = 4; i < fields.size(); i++) {
+                if (const char* problem = parseTier(fields[i], event)) {
+                    rows.pop_back();
+                    return problem;
+                }
+            }
+            return nullptr;
+        },
+        [&](Event& event) -> const char* {
+            if (engine.index.eventById.count(event.eventID)) return "DUPLICATE_ID";
+            engine.eventlist.push_back(move(event));
+            engine.index.addEvent(engine.eventlist, engine.eventlist.size() - 1);
+            return nullptr;
+        });
+}
+
+ImportReport importBookings(BookingEngine& engine, const string& filename) {
+    return importFile<Booking>(filename,
+        [&](const vector<string_view>& fields, vector<Booking>& rows) -> const char* {
+            int bookingId, userId, eventId, tickets;
+            float totalPrice;
+            int seatId = -1;
+            if (fields.size() != 7 && fields.size() != 8) return "BAD_FIELD_COUNT";
+            if (!parseField(fields[0], bookingId) || bookingId <= 0) return "BAD_ID";
+            if (!parseField(fields[1], userId) || !engine.index.findUser(engine.Userlist, userId)) {
+                return "UNKNOWN_USER";
+            }
+            const Event* event = parseField(fields[2], eventId)
+                ? engine.index.findEvent((const vector<Event>&)engine.eventlist, eventId) : nullptr;
+            if (!event) return "UNKNOWN_EVENT";
+            if (!parseField(fields[3], tickets) || tickets <= 0) return "BAD_TICKETS";
+            if (!parseField(fields[4], totalPrice) || totalPrice < 0) return "BAD_PRICE";
+            if (fields[5] != "Confirmed" && fields[5] != "Cancelled") return "BAD_STATUS";
+
+            const TicketTier* tier = event->findTier(string_view(fields[6]));
+            if (!tier) return "UNKNOWN_TIER";
+            if (fields.size() == 8 && (!parseField(fields[7], seatId) || seatId < 0 || !tier->seats)) {
+                return "BAD_SEAT";
+            }
+
+            rows.emplace_back(bookingId, userId, eventId, tickets, totalPrice, tier->nameId, seatId);
+            rows.back().status = parseStatus(fields[5]);
+            return nullptr;
+        },
+        [&](Booking& booking) -> const char* {
+            if (engine.index.bookingById.count(booking.bookingId)) return "DUPLICATE_ID";
+            if (booking.status == STATUS_CONFIRMED && booking.seatId >= 0) {
+                TicketTier* tier = engine.index.findEvent(engine.eventlist, booking.eventId)->findTier(booking.tierId);
+                if (!tier->seats->markTaken(booking.seatId, booking.tickets)) return "BAD_SEAT";
+            }
+            engine.addImported(booking);
+            return nullptr;
+        });
+}
+
+int runImport(BookingEngine& engine, const vector<string>& args) {
+    if (args.empty() || args.size() % 2 != 0) {
+        cerr << "Usage: --import <users|events|bookings> <file> [<kind> <file>...]\n";
+        return 1;
+    }
+    // Check every argument before anything is imported
+    for (size_t i = 0; i < args.size(); i += 2) {
+        if (args[i] != "users" && args[i] != "events" && args[i] != "bookings") {
+            cerr << "Unknown import kind " << args[i] << " (users, events or bookings)\n";
+            return 1;
+        }
+        if (!ifstream(args[i + 1])) {
+            cerr << "Error opening " << args[i + 1] << "\n";
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < args.size(); i += 2) {
+        const string& kind = args[i];
+        const string& filename = args[i + 1];
+        auto start = chrono::steady_clock::now();
+        ImportReport report = kind == "users" ? importUsers(engine, filename)
+                            : kind == "events" ? importEvents(engine, filename)
+                            : importBookings(engine, filename);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << filename << ": " << report.imported << " " << kind << " imported, "
+             << report.rejected << " rows rejected";
+        if (report.rejected > 0) cout << " (see " << filename << ".errors)";
+        cout << ", " << fixed << setprecision(2) << seconds << " s\n";
+    }
+
+    // Users first, so the binary snapshot is stamped with the new users.txt
+    saveUsers(engine.Userlist);
+    engine.checkpoint();
+    return 0;
+}
+
+// =============== SERVER MODE ===============
+// Run with: event-ticket-system --server [port | unix:<path>]   (default 9090)
+// Listens on 127.0.0.1:<port> or a Unix domain socket and serves the
+// scripted-mode commands to many clients against one shared inventory.
+// Framing: each request is one line; each response is the lines that
+// command prints in scripted mode. Requests on one connection are answered
+// in order.
+//
+// One thread runs a non-blocking epoll loop that accepts connections and
+// reads requests; complete lines are handed to a pool of worker threads,
+// which run them through the CommandHandler and write the replies back.
+// A connection stops being read while it has MAX_CONNECTION_BUFFER bytes of
+// requests or replies waiting, and resumes as workers and the client catch
+// up, so a client that never reads its replies cannot grow the server.
+// Ctrl+C (or SIGTERM) stops the server and writes a checkpoint.
+#ifdef BOOKING_SERVER
+const size_t MAX_REQUEST_LINE = 64 * 1024;
+const size_t MAX_CONNECTION_BUFFER = 1024 * 1024;
+
+volatile sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+class ServerConnection {
+public:
+    int fd;
+    mutex lock;
+    string input;          // bytes read but not yet split into requests
+    deque<string> pending; // complete request lines waiting for a worker;
+                           // an empty line stands for one that was too long
+    size_t pendingBytes = 0;
+    string output;         // reply bytes not yet accepted by the socket
+    uint32_t events = EPOLLIN | EPOLLRDHUP;  // what epoll is watching for
+    bool queued = false;   // a worker owns (or is about to own) pending
+    bool wantWrite = false;
+    bool rejected = false; // sent a line that was too long: nothing more is read
+    bool hangUp = false;   // close once output is sent
+    bool closing = false;
+
+    ServerConnection(int socketFd) : fd(socketFd) {}
+
+    bool requestsFull() const {
+        return input.size() + pendingBytes >= MAX_CONNECTION_BUFFER;
+    }
+
+    bool outputFull() const {
+        return output.size() >= MAX_CONNECTION_BUFFER;
+    }
+
+    // Worth handing to a worker
+    bool runnable() const {
+        return !pending.empty() && !queued && !outputFull();
+    }
+
+    // The fd is only closed once no worker holds the connection, so it
+    // cannot be reused under a worker's feet.
+    ~ServerConnection() {
+        close(fd);
+    }
+};
+
+class BookingServer {
+public:
+    CommandHandler& handler;
+    int listenFd = -1;
+    int epollFd = -1;
+    string unixPath;
+    unordered_map<int, shared_ptr<ServerConnection>> connections;
+
+    mutex queueMutex;
+    condition_variable queueReady;
+    deque<shared_ptr<ServerConnection>> workQueue;
+    vector<thread> workers;
+    bool stopping = false;
+
+    atomic<size_t> requests{0};
+
+    BookingServer(CommandHandler& commandHandler) : handler(commandHandler) {}
+
+    ~BookingServer() {
+        if (epollFd >= 0) close(epollFd);
+        if (listenFd >= 0) close(listenFd);
+        if (!unixPath.empty()) unlink(unixPath.c_str());
+    }
+
+    bool listenOn(const string& address) {
+        if (address.rfind("unix:", 0) == 0) {
+            unixPath = address.substr(5);
+            sockaddr_un addr{};
+            if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path)) {
+                cerr << "Invalid socket path " << unixPath << "\n";
+                unixPath.clear();
+                return false;
+            }
+            addr.sun_family = AF_UNIX;
+            strcpy(addr.sun_path, unixPath.c_str());
+            unlink(unixPath.c_str());
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                cerr << "Error binding " << unixPath << ": " << strerror(errno) << "\n";
+                return false;
+            }
+        } else {
+            int port;
+            if (!parseField(address, port) || port <= 0 || port > 65535) {
+                cerr << "Invalid port " << address << "\n";
+                return false;
+            }
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int reuse = 1;
+            if (listenFd >= 0) setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+                cerr << "Error binding 127.0.0.1:" << port << ": " << strerror(errno) << "\n";
+                return false;
+            }
+        }
+        if (listen(listenFd, SOMAXCONN) < 0) {
+            cerr << "Error listening: " << strerror(errno) << "\n";
+            return false;
+        }
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = listenFd;
+        return epollFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) == 0;
+    }
+
+    void run(unsigned workerCount) {
+        for (unsigned i = 0; i < workerCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+
+        vector<epoll_event> events(1024);
+        auto lastTick = chrono::steady_clock::now();
+        while (!serverStopRequested) {
+            int ready = epoll_wait(epollFd, events.data(), events.size(), 500);
+            if (ready < 0 && errno != EINTR) break;
+            // Holds expire in whole wheel ticks, so a busy loop need not check sooner
+            auto now = chrono::steady_clock::now();
+            if (now - lastTick >= chrono::milliseconds(HoldWheel::TICK_MS)) {
+                lastTick = now;
+                handler.tick();
+            }
+            for (int i = 0; i < ready; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections();
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                shared_ptr<ServerConnection> conn = it->second;
+                if (events[i].events & EPOLLOUT) flushOutput(conn);
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                    readRequests(conn);  // also notices the peer closing
+                } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    dropConnection(conn);
+                }
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& worker : workers) worker.join();
+        connections.clear();
+    }
+
+private:
+    void acceptConnections() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;  // EAGAIN, or out of descriptors until some close
+            if (unixPath.empty()) {
+                int noDelay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                close(fd);
+                continue;
+            }
+            connections[fd] = make_shared<ServerConnection>(fd);
+        }
+    }
+
+    // Loop thread only
+    void dropConnection(const shared_ptr<ServerConnection>& conn) {
+        {
+            lock_guard<mutex> lock(conn->lock);
+            conn->closing = true;
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+        connections.erase(conn->fd);
+    }
+
+    void readRequests(const shared_ptr<ServerConnection>& conn) {
+        char buffer[16384];
+        bool peerClosed = false;
+        bool dispatch = false;
+        {
+            lock_guard<mutex> lock(conn->lock);
+            // Level-triggered, so whatever is left is read once there is room
+            while (!conn->rejected && !conn->requestsFull() && !conn->outputFull()) {
+                ssize_t n = recv(conn->fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    conn->input.append(buffer, n);
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) peerClosed = true;
+                if (n < 0 && errno == EINTR) continue;
+                break;
+            }
+
+            size_t start = 0;
+            size_t end;
+            while ((end = conn->input.find('\n', start)) != string::npos) {
+                string line = conn->input.substr(start, end - start);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) {
+                    conn->pendingBytes += line.size();
+                    conn->pending.push_back(move(line));
+                }
+                start = end + 1;
+            }
+            conn->input.erase(0, start);
+            // Answered after the requests before it, then the connection closes
+            if (conn->input.size() > MAX_REQUEST_LINE) {
+                conn->input.clear();
+                conn->rejected = true;
+                conn->pending.emplace_back();
+            }
+
+            dispatch = conn->runnable();
+            if (dispatch) conn->queued = true;
+            watch(*conn);
+        }
+
+        if (dispatch) queueWork(conn);
+        if (peerClosed) {
+            // Replies still owed to a half-closed client are sent by the
+            // worker, which holds its own reference to the connection.
+            dropConnection(conn);
+        }
+    }
+
+    void queueWork(const shared_ptr<ServerConnection>& conn) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            workQueue.push_back(conn);
+        }
+        queueReady.notify_one();
+    }
+
+    // Called with conn.lock held. Asks epoll for input only while there is
+    // room for it, and for EPOLLOUT while replies are left over.
+    void watch(ServerConnection& conn) {
+        bool reading = !conn.rejected && !conn.requestsFull() && !conn.outputFull();
+        uint32_t events = (reading ? (uint32_t)(EPOLLIN | EPOLLRDHUP) : 0u) |
+                          (conn.wantWrite ? (uint32_t)EPOLLOUT : 0u);
+        if (events == conn.events || conn.closing) return;
+        conn.events = events;
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+    }
+
+    // Called with conn->lock held. Writes what the socket accepts and asks
+    // epoll for EPOLLOUT while anything is left over. A connection to hang up
+    // is shut down once all is sent, which epoll reports as EPOLLHUP.
+    void writeOutput(ServerConnection& conn) {
+        while (!conn.output.empty()) {
+            ssize_t n = send(conn.fd, conn.output.data(), conn.output.size(), MSG_NOSIGNAL);
+            if (n > 0) {
+                conn.output.erase(0, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) conn.output.clear();
+            break;
+        }
+        if (conn.output.empty() && conn.hangUp) shutdown(conn.fd, SHUT_RDWR);
+        conn.wantWrite = !conn.output.empty() && !conn.closing;
+        watch(conn);
+    }
+
+    // Loop thread only. A worker leaves a connection whose replies have
+    // piled up; it is queued again once they drain.
+    void flushOutput(const shared_ptr<ServerConnection>& conn) {
+        bool dispatch;
+        {
+            lock_guard<mutex> lock(conn->lock);
+            writeOutput(*conn);
+            dispatch = conn->runnable();
+            if (dispatch) conn->queued = true;
+        }
+        if (dispatch) queueWork(conn);
+    }
+
+    void workerLoop() {
+        vector<string_view> fields;
+        ostringstream reply;
+        while (true) {
+            shared_ptr<ServerConnection> conn;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !workQueue.empty(); });
+                if (workQueue.empty()) return;
+                conn = move(workQueue.front());
+                workQueue.pop_front();
+            }
+
+            // Drain this connection's requests in order; the epoll thread
+            // does not queue it again while queued is set.
+            while (true) {
+                string line;
+                {
+                    lock_guard<mutex> lock(conn->lock);
+                    if (conn->pending.empty() || conn->outputFull()) {
+                        conn->queued = false;
+                        break;
+                    }
+                    line = move(conn->pending.front());
+                    conn->pending.pop_front();
+                    conn->pendingBytes -= line.size();
+                }
+
+                reply.str("");
+                if (line.empty()) {
+                    reply << "ERR,request,TOO_LONG\n";
+                } else {
+                    splitFields(line, fields);
+                    handler.execute(fields, reply);
+                    requests++;
+                }
+
+                lock_guard<mutex> lock(conn->lock);
+                conn->output += reply.str();
+                if (line.empty()) conn->hangUp = true;
+                writeOutput(*conn);
+            }
+        }
+    }
+};
+
+int runServer(BookingEngine& engine, const string& address) {
+    CommandHandler handler(engine);
+    BookingServer server(handler);
+    if (!server.listenOn(address)) return 1;
+
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+    signal(SIGPIPE, SIG_IGN);
+
+    unsigned workerCount = max(2u, thread::hardware_concurrency());
+    cout << "Serving on " << (server.unixPath.empty() ? "127.0.0.1:" + address : server.unixPath)
+         << " with " << workerCount << " workers (Ctrl+C to stop)" << endl;
+    auto start = chrono::steady_clock::now();
+    server.run(workerCount);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    handler.finish();
+    cout << "Stopped after " << server.requests.load() << " requests in "
+         << fixed << setprecision(1) << seconds << " s\n";
+    return 0;
+}
+#else
+int runServer(BookingEngine&, const string&) {
+    cerr << "Server mode needs Linux (epoll)\n";
+    return 1;
+}
+#endif
+
+// =============== BENCHMARKS ===============
+// Run with: event-ticket-system --bench [rows ...]
+// For each size, synthetic users.txt, events.txt and bookings.txt are written
+// to bench_data/ and the load, book, cancel and admin report paths are timed.
+class LatencyStats {
+public:
+    string name;
+    vector<double> samples;  // microseconds
+    double totalMs = 0;
+
+    LatencyStats(const string& n) : name(n) {}
+
+    void add(chrono::steady_clock::duration elapsed) {
+        double us = chrono::duration<double, micro>(elapsed).count();
+        samples.push_back(us);
+        totalMs += us / 1000.0;
+    }
+
+    double percentile(double p) {
+        if (samples.empty()) return 0;
+        size_t rank = (size_t)(p * (samples.size() - 1));
+        nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    // rowsPerOp turns per-call timings into a row throughput for the loaders
+    void print(size_t rowsPerOp = 1) {
+        double seconds = totalMs / 1000.0;
+        double throughput = seconds > 0 ? samples.size() * rowsPerOp / seconds : 0;
+        cout << left << setw(16) << name
+             << right << setw(10) << samples.size()
+             << setw(14) << fixed << setprecision(2) << totalMs
+             << setw(16) << setprecision(0) << throughput
+             << setw(12) << setprecision(1) << percentile(0.50)
+             << setw(12) << percentile(0.99) << "\n";
+    }
+};
+
+void generateBenchmarkData(size_t rows, mt19937& rng) {
+    ofstream users("users.txt");
+    for (size_t i = 1; i <= rows; i++) {
+        users << i << ",user" << i << "\n";
+    }
+
+    // Plenty of inventory so the booking benchmark never runs a tier dry
+    ofstream events("events.txt");
+    for (size_t i = 1; i <= rows; i++) {
+        events << i << ",Event " << i << ",Venue " << i % 97 << ","
+               << setw(2) << setfill('0') << (i % 28 + 1) << "-"
+               << setw(2) << (i % 12 + 1) << "-" << setfill(' ') << 2026
+               << ",VIP:150.00:1000000,Standard:45.50:1000000\n";
+    }
+
+    ofstream bookings("bookings.txt");
+    uniform_int_distribution<size_t> pick(1, rows);
+    for (size_t i = 1; i <= rows; i++) {
+        bool vip = i % 3 == 0;
+        int tickets = (int)(i % 5 + 1);
+        bookings << i << "," << pick(rng) << "," << pick(rng) << "," << tickets << ","
+                 << fixed << setprecision(2) << tickets * (vip ? 150.0f : 45.5f) << ","
+                 << (i % 10 == 0 ? "Cancelled" : "Confirmed") << ","
+                 << (vip ? "VIP" : "Standard") << "\n";
+    }
+}
+
+// Accepts and drops everything written to it, so timed output costs only
+// the formatting
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c == EOF ? 0 : c; }
+    streamsize xsputn(const char*, streamsize count) override { return count; }
+};
+
+void runBenchmark(size_t rows) {
+    const int loadRuns = 5;
+    const size_t operations = min<size_t>(rows, 100000);
+    mt19937 rng(42);
+
+    cout << "\n===== " << rows << " rows =====\n";
+    generateBenchmarkData(rows, rng);
+    remove("bookings.journal");
+
+    cout << left << setw(16) << "OPERATION" << right << setw(10) << "OPS"
+         << setw(14) << "TOTAL MS" << setw(16) << "PER SEC"
+         << setw(12) << "P50 US" << setw(12) << "P99 US" << "\n"
+         << string(80, '-') << "\n";
+
+    LatencyStats usersStats("loadUsers"), eventsStats("loadEvents"), bookingsStats("loadBookings");
+    vector<User> Userlist;
+    vector<Event> eventlist;
+    vector<Booking> bookings;
+    for (int run = 0; run < loadRuns; run++) {
+        auto start = chrono::steady_clock::now();
+        Userlist = loadUsers();
+        usersStats.add(chrono::steady_clock::now() - start);
+
+        start = chrono::steady_clock::now();
+        eventlist = loadEvents();
+        eventsStats.add(chrono::steady_clock::now() - start);
+
+        start = chrono::steady_clock::now();
+        bookings = loadBookings(eventlist);
+        bookingsStats.add(chrono::steady_clock::now() - start);
+    }
+    usersStats.print(Userlist.size());
+    eventsStats.print(eventlist.size());
+    bookingsStats.print(bookings.size());
+
+    DataIndex index;
+    index.rebuild(Userlist, eventlist, bookings);
+    BookingJournal journal;
+    journal.open();
+    BookingEngine engine(eventlist, Userlist, bookings, index, journal);
+
+    LatencyStats bookStats("book"), cancelStats("cancel");
+    uniform_int_distribution<int> pickId(1, (int)rows);
+    vector<int> booked;
+    booked.reserve(operations);
+    for (size_t i = 0; i < operations; i++) {
+        int bookingId;
+        int userId = pickId(rng);
+        int eventId = pickId(rng);
+        auto start = chrono::steady_clock::now();
+        BookResult result = engine.book(userId, eventId, i % 3 ? "Standard" : "VIP", 2, bookingId);
+        bookStats.add(chrono::steady_clock::now() - start);
+        if (result == BOOK_OK) booked.push_back(bookingId);
+    }
+    bookStats.print();
+
+    for (int bookingId : booked) {
+        auto start = chrono::steady_clock::now();
+        engine.cancel(bookingId);
+        cancelStats.add(chrono::steady_clock::now() - start);
+    }
+    cancelStats.print();
+
+    // Time the admin report with its output thrown away
+    LatencyStats reportStats("adminReport");
+    NullBuffer nullOut;
+    streambuf* saved = cout.rdbuf(&nullOut);
+    for (int run = 0; run < loadRuns; run++) {
+        auto start = chrono::steady_clock::now();
+        viewAllBookingsAdmin(engine.snapshot(), Userlist, eventlist, index);
+        reportStats.add(chrono::steady_clock::now() - start);
+    }
+    cout.rdbuf(saved);
+    reportStats.print(bookings.size());
+
+    // Full-history totals: row-by-row over Booking objects vs the column kernels
+    LatencyStats buildStats("columnBuild"), rowStats("rowScan"), columnStats("columnScan"), eventStats("eventScan");
+    ColumnarBookings columns;
+    for (int run = 0; run < loadRuns; run++) {
+        auto start = chrono::steady_clock::now();
+        columns.build(bookings);
+        buildStats.add(chrono::steady_clock::now() - start);
+    }
+    buildStats.print(bookings.size());
+    SalesTotals rowTotals, columnTotals;
+    for (int run = 0; run < loadRuns; run++) {
+        auto start = chrono::steady_clock::now();
+        rowTotals = SalesTotals();
+        for (const auto& booking : bookings) {
+            if (booking.status == STATUS_CONFIRMED) {
+                rowTotals.confirmed++;
+                rowTotals.tickets += booking.tickets;
+                rowTotals.revenueCents += toCents(booking.totalPrice);
+            } else {
+                rowTotals.cancelled++;
+            }
+        }
+        rowStats.add(chrono::steady_clock::now() - start);
+
+        start = chrono::steady_clock::now();
+        columnTotals = columns.summarize();
+        columnStats.add(chrono::steady_clock::now() - start);
+
+        int eventId = pickId(rng);
+        start = chrono::steady_clock::now();
+        SalesTotals eventTotals = columns.summarizeEvent(eventId);
+        eventStats.add(chrono::steady_clock::now() - start);
+        if (eventTotals.tickets != engine.totals->forEvent(eventId).tickets) {
+            cout << "WARNING: column totals for event " << eventId << " do not match\n";
+        }
+    }
+    rowStats.print(bookings.size());
+    columnStats.print(bookings.size());
+    eventStats.print(bookings.size());
+    if (rowTotals.tickets != columnTotals.tickets || rowTotals.revenueCents != columnTotals.revenueCents ||
+        rowTotals.confirmed != columnTotals.confirmed || rowTotals.cancelled != columnTotals.cancelled) {
+        cout << "WARNING: column totals do not match row totals\n";
+    }
+
+    journal.waitForCompaction();
+}
+
+void runBenchmarks(const vector<size_t>& sizes) {
+    makeDirectory("bench_data");
+    if (!changeDirectory("bench_data")) {
+        cerr << "Error entering bench_data directory\n";
+        return;
+    }
+    quietScreens = true;
+    for (size_t rows : sizes) {
+        runBenchmark(rows);
+    }
+}
+
+// =============== FLASH SALE ===============
+// Run with: event-ticket-system --flash-sale [option=value ...]
+// Rehearses an on-sale in flash_data/: many buyer threads start at the same
+// moment and go through the kiosk's booking path (hold, then confirm or
+// release) and cancel some of their own bookings, against synthetic events
+// whose popularity follows a Zipf distribution. Prints the orders finished
+// each second and the hold/confirm/cancel latencies, then checks that every
+// tier still accounts for all its tickets.
+enum BurstProfile {
+    BURST_STEADY,  // every buyer pauses `think` between orders throughout
+    BURST_SPIKE,   // no pauses for the first fifth of the sale, then as steady
+    BURST_WAVES    // alternating seconds of no pauses and ten times `think`
+};
+
+class FlashSaleOptions {
+public:
+    int buyers = 64;
+    int events = 100;
+    int tickets = 5000;     // per event: Standard tier, plus a tenth as seated VIP
+    int seconds = 10;
+    double zipf = 1.1;      // popularity of the k-th event is 1 / k^zipf
+    double cancel = 0.1;    // chance an order is a cancellation of one of the buyer's bookings
+    double abandon = 0.05;  // chance a hold is released instead of confirmed
+    int think = 1000;       // microseconds between a buyer's orders
+    BurstProfile burst = BURST_SPIKE;
+    unsigned seed = 42;
+
+    // name=value; false if the option is unknown or its value does not parse
+    bool set(string_view option) {
+        size_t equals = option.find('=');
+        if (equals == string_view::npos) return false;
+        string_view name = option.substr(0, equals);
+        string_view value = option.substr(equals + 1);
+        if (name == "burst") {
+            if (value == "steady") burst = BURST_STEADY;
+            else if (value == "spike") burst = BURST_SPIKE;
+            else if (value == "waves") burst = BURST_WAVES;
+            else return false;
+            return true;
+        }
+        if (name == "buyers") return parseField(value, buyers) && buyers > 0;
+        if (name == "events") return parseField(value, events) && events > 0;
+        if (name == "tickets") return parseField(value, tickets) && tickets > 0 && tickets <= SeatMap::MAX_SEATS;
+        if (name == "seconds") return parseField(value, seconds) && seconds > 0;
+        if (name == "zipf") return parseField(value, zipf) && zipf >= 0;
+        if (name == "cancel") return parseField(value, cancel) && cancel >= 0 && cancel <= 1;
+        if (name == "abandon") return parseField(value, abandon) && abandon >= 0 && abandon <= 1;
+        if (name == "think") return parseField(value, think) && think >= 0;
+        if (name == "seed") return parseField(value, seed);
+        return false;
+    }
+
+    const char* burstName() const {
+        return burst == BURST_STEADY ? "steady" : burst == BURST_SPIKE ? "spike" : "waves";
+    }
+
+    // Microseconds a buyer waits before its next order, elapsed seconds into the sale
+    int pause(double elapsed) const {
+        if (burst == BURST_SPIKE) return elapsed < seconds / 5.0 ? 0 : think;
+        if (burst == BURST_WAVES) return (int)elapsed % 2 == 0 ? 0 : think * 10;
+        return think;
+    }
+};
+
+// Picks event positions, the k-th (from 0) with weight 1 / (k + 1)^s
+class ZipfPicker {
+public:
+    ZipfPicker(int count, double s) {
+        double total = 0;
+        for (int k = 1; k <= count; k++) {
+            total += 1 / pow(k, s);
+            cumulative.push_back(total);
+        }
+    }
+
+    int pick(mt19937& rng) const {
+        double u = uniform_real_distribution<double>(0, cumulative.back())(rng);
+        size_t k = upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+        return (int)min(k, cumulative.size() - 1);
+    }
+
+private:
+    vector<double> cumulative;
+};
+
+// One simulated buyer's thread and what it got done
+class FlashBuyer {
+public:
+    int userId = 0;
+    mt19937 rng;
+    vector<int> bookingIds;  // its confirmed bookings
+    vector<uint64_t> perSecond;  // orders finished in each second of the sale
+    uint64_t confirmed = 0;
+    uint64_t soldOut = 0;
+    uint64_t noSeats = 0;
+    uint64_t abandoned = 0;
+    uint64_t cancelled = 0;
+    thread worker;
+};
+
+// Every tier must account for all of its tickets, and no seat may be sold
+// twice. original holds each tier's starting count, in event and tier order.
+bool checkFlashInventory(const char* label, const BookingEngine& engine, const vector<int>& original) {
+    map<pair<int, TierId>, long long> confirmedTickets;
+    map<pair<int, TierId>, vector<bool>> seatsSold;
+    long long doubleSold = 0;
+    for (const auto& booking : engine.bookings) {
+        if (booking.status != STATUS_CONFIRMED) continue;
+        confirmedTickets[{booking.eventId, booking.tierId}] += booking.tickets;
+        if (booking.seatId < 0) continue;
+        vector<bool>& seats = seatsSold[{booking.eventId, booking.tierId}];
+        seats.resize(max<size_t>(seats.size(), booking.seatId + booking.tickets));
+        for (int seat = booking.seatId; seat < booking.seatId + booking.tickets; seat++) {
+            if (seats[seat]) doubleSold++;
+            seats[seat] = true;
+        }
+    }
+    size_t tierCount = 0;
+    long long sold = 0, inventory = 0;
+    int mismatches = 0;
+    for (const auto& event : engine.eventlist) {
+        for (const auto& tier : event.ticketTiers) {
+            long long tierSold = confirmedTickets[{event.eventID, tier.nameId}];
+            int initial = original[tierCount++];
+            sold += tierSold;
+            inventory += initial;
+            if (tier.available() + tierSold != initial) {
+                if (mismatches++ < 10) {
+                    cout << "MISMATCH: event " << event.eventID << " " << event.tierName(tier) << ": "
+                         << tier.available() << " remaining + " << tierSold << " confirmed != " << initial << "\n";
+                }
+            }
+        }
+    }
+    bool ok = mismatches == 0 && doubleSold == 0 && sold == engine.totals->system.tickets;
+    cout << "Inventory check (" << label << "): " << tierCount << " tiers, " << sold << " of " << inventory
+         << " tickets sold, " << mismatches << " mismatched tiers, " << doubleSold
+         << " seats sold twice: " << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+int runFlashSale(const FlashSaleOptions& options) {
+    makeDirectory("flash_data");
+    if (!changeDirectory("flash_data")) {
+        cerr << "Error entering flash_data directory\n";
+        return 1;
+    }
+    quietScreens = true;
+    remove("bookings.journal");
+    remove("bookings.journal.compacting");
+    remove("waitlist.txt");
+    remove("data.snapshot");
+
+    vector<User> Userlist;
+    for (int i = 1; i <= options.buyers; i++) {
+        Userlist.emplace_back(i, "buyer" + to_string(i));
+    }
+    vector<Event> eventlist;
+    eventlist.reserve(options.events);
+    int vipRows = max(1, options.tickets / 100);
+    for (int i = 1; i <= options.events; i++) {
+        Event& event = eventlist.emplace_back(i, "Flash Sale " + to_string(i), "Arena", "01-01-2030");
+        event.addTicketTier("Standard", 45.50f, options.tickets);
+        event.addTicketTier("VIP", 150.00f, vipRows * 10, vipRows, 10);
+    }
+    vector<Booking> bookings;
+    saveUsers(Userlist);
+    saveEvents(eventlist);
+    saveBookings(bookings, eventlist);
+
+    // What each tier starts with, in event and tier order
+    vector<int> original;
+    for (const auto& event : eventlist) {
+        for (const auto& tier : event.ticketTiers) original.push_back(tier.available());
+    }
+
+    DataIndex index;
+    index.rebuild(Userlist, eventlist, bookings);
+    BookingJournal journal;
+    journal.open();
+    BookingEngine engine(eventlist, Userlist, bookings, index, journal);
+
+    cout << "===== FLASH SALE: " << options.buyers << " buyers, " << options.events << " events, "
+         << options.burstName() << " burst, zipf " << options.zipf
+         << ", " << options.seconds << " s =====\n";
+
+    ZipfPicker popularity(options.events, options.zipf);
+    atomic<bool> started(false);
+    auto start = chrono::steady_clock::now();
+    auto deadline = start;
+    vector<FlashBuyer> buyers(options.buyers);
+    for (int i = 0; i < options.buyers; i++) {
+        FlashBuyer& buyer = buyers[i];
+        buyer.userId = i + 1;
+        buyer.rng.seed(options.seed + i);
+        buyer.perSecond.assign(options.seconds + 1, 0);
+        buyer.worker = thread([&, &buyer = buyer]() {
+            // Everyone starts the moment the sale opens
+            while (!started.load(memory_order_acquire)) this_thread::yield();
+            uniform_real_distribution<double> chance(0, 1);
+            uniform_int_distribution<int> quantity(1, 4);
+            while (true) {
+                auto now = chrono::steady_clock::now();
+                if (now >= deadline) break;
+                double elapsed = chrono::duration<double>(now - start).count();
+
+                if (!buyer.bookingIds.empty() && chance(buyer.rng) < options.cancel) {
+                    size_t pick = uniform_int_distribution<size_t>(0, buyer.bookingIds.size() - 1)(buyer.rng);
+                    if (engine.cancel(buyer.bookingIds[pick])) buyer.cancelled++;
+                    buyer.bookingIds[pick] = buyer.bookingIds.back();
+                    buyer.bookingIds.pop_back();
+                } else {
+                    int eventId = popularity.pick(buyer.rng) + 1;
+                    const char* tierName = chance(buyer.rng) < 0.25 ? "VIP" : "Standard";
+                    SeatHold seatHold;
+                    BookResult held = engine.hold(buyer.userId, eventId, tierName, quantity(buyer.rng), seatHold);
+                    int bookingId;
+                    if (held == BOOK_SOLD_OUT) {
+                        buyer.soldOut++;
+                    } else if (held == BOOK_NO_ADJACENT_SEATS) {
+                        buyer.noSeats++;
+                    } else if (held != BOOK_OK) {
+                        cerr << "Unexpected hold result " << held << "\n";
+                    } else if (chance(buyer.rng) < options.abandon) {
+                        engine.releaseHold(seatHold.holdId);
+                        buyer.abandoned++;
+                    } else if (engine.confirmHold(seatHold.holdId, bookingId) == BOOK_OK) {
+                        buyer.bookingIds.push_back(bookingId);
+                        buyer.confirmed++;
+                    }
+                }
+                buyer.perSecond[min((size_t)elapsed, buyer.perSecond.size() - 1)]++;
+
+                int pause = options.pause(elapsed);
+                if (pause > 0) this_thread::sleep_for(chrono::microseconds(pause));
+            }
+        });
+    }
+    start = chrono::steady_clock::now();
+    deadline = start + chrono::seconds(options.seconds);
+    started.store(true, memory_order_release);
+    for (auto& buyer : buyers) buyer.worker.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Throughput, second by second
+    FlashBuyer total;
+    total.perSecond.assign(options.seconds + 1, 0);
+    for (const auto& buyer : buyers) {
+        for (size_t i = 0; i < buyer.perSecond.size(); i++) total.perSecond[i] += buyer.perSecond[i];
+        total.confirmed += buyer.confirmed;
+        total.soldOut += buyer.soldOut;
+        total.noSeats += buyer.noSeats;
+        total.abandoned += buyer.abandoned;
+        total.cancelled += buyer.cancelled;
+    }
+    uint64_t orders = 0;
+    uint64_t slowest = numeric_limits<uint64_t>::max();
+    cout << left << setw(10) << "SECOND" << right << setw(12) << "ORDERS" << "\n" << string(22, '-') << "\n";
+    for (int second = 0; second < options.seconds; second++) {
+        cout << left << setw(10) << second << right << setw(12) << total.perSecond[second] << "\n";
+        orders += total.perSecond[second];
+        slowest = min(slowest, total.perSecond[second]);
+    }
+    orders += total.perSecond[options.seconds];  // the last orders to finish after the deadline
+    cout << "\nOrders: " << orders << " in " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(0) << orders / seconds << " per second, " << slowest
+         << " in the slowest second)\n";
+    cout << "Confirmed: " << total.confirmed << " | Sold out: " << total.soldOut
+         << " | No adjacent seats: " << total.noSeats << " | Abandoned holds: " << total.abandoned
+         << " | Cancelled: " << total.cancelled << "\n\n";
+
+    // Latencies as recorded by the engine itself
+    array<OpSummary, STAT_OP_COUNT> summaries = OpStats::summarize();
+    cout << left << setw(12) << "OPERATION" << right << setw(12) << "COUNT" << setw(12) << "MEAN US"
+         << setw(12) << "P50 US" << setw(12) << "P90 US" << setw(12) << "P99 US" << setw(12) << "MAX US"
+         << "\n" << string(84, '-') << "\n" << setprecision(1);
+    for (StatOp op : {STAT_HOLD, STAT_CONFIRM, STAT_CANCEL}) {
+        const OpSummary& summary = summaries[op];
+        cout << left << setw(12) << STAT_NAMES[op] << right << setw(12) << summary.count
+             << setw(12) << summary.meanUs << setw(12) << summary.p50Us << setw(12) << summary.p90Us
+             << setw(12) << summary.p99Us << setw(12) << summary.maxUs << "\n";
+    }
+
+    journal.waitForCompaction();
+    cout << "\n";
+    bool ok = checkFlashInventory("in memory", engine, original);
+
+    // A restart must arrive at the same counts from the data files and journal
+    vector<User> savedUsers;
+    vector<Event> savedEvents;
+    vector<Booking> savedBookings;
+    loadDataFiles(savedUsers, savedEvents, savedBookings);
+    DataIndex savedIndex;
+    savedIndex.rebuild(savedUsers, savedEvents, savedBookings);
+    BookingJournal savedJournal;
+    savedJournal.replay(savedUsers, savedEvents, savedBookings, savedIndex);
+    BookingEngine reloaded(savedEvents, savedUsers, savedBookings, savedIndex, savedJournal);
+    ok = checkFlashInventory("reloaded", reloaded, original) && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--flash-sale") {
+        FlashSaleOptions options;
+        for (int i = 2; i < argc; i++) {
+            if (!options.set(argv[i])) {
+                cerr << "Unknown or invalid option " << argv[i] << "\n"
+                     << "Options: buyers= events= tickets= seconds= zipf= cancel= abandon= think= "
+                     << "burst=steady|spike|waves seed=\n";
+                return 1;
+            }
+        }
+        return runFlashSale(options);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        vector<size_t> sizes;
+        for (int i = 2; i < argc; i++) {
+            string_view arg = argv[i];
+            size_t rows = 0;
+            auto result = from_chars(arg.data(), arg.data() + arg.size(), rows);
+            if (result.ec != errc() || result.ptr != arg.data() + arg.size() || rows == 0) {
+                cerr << "Invalid row count " << arg << "\n"
+                     << "Usage: event-ticket-system --bench [rows ...]\n";
+                return 1;
+            }
+            sizes.push_back(rows);
+        }
+        if (sizes.empty()) sizes = {1000, 10000, 100000};
+        runBenchmarks(sizes);
+        return 0;
+    }
+
+    if (argc > 1 && string(argv[1]) == "--export-snapshot") {
+        vector<Event> eventlist;
+        vector<User> Userlist;
+        vector<Booking> bookings;
+        if (!loadSnapshotFile(Userlist, eventlist, bookings, "data.snapshot", false)) {
+            cerr << "No valid data.snapshot to export\n";
+            return 1;
+        }
+        saveUsers(Userlist);
+        saveEvents(eventlist);
+        saveBookings(bookings, eventlist);
+        cout << "Exported " << Userlist.size() << " users, " << eventlist.size()
+             << " events and " << bookings.size() << " bookings\n";
+        return 0;
+    }
+
+    // Several copies started with --shared sell from one inventory
+    bool sharedMode = argc > 1 && string(argv[1]) == "--shared";
+    if (sharedMode) {
+        argc--;
+        argv++;
+        if (argc > 1 && string(argv[1]) == "--import") {
+            cerr << "--import cannot be combined with --shared\n";
+            return 1;
+        }
+    }
+
+    initializeDataFiles();
+    vector<Event> eventlist;
+    vector<User> Userlist;
+    vector<Booking> bookings;
+    // Another process may be writing the data files when sharing
+    if (!sharedMode) BookingJournal::finishSnapshot();
+    loadDataFiles(Userlist, eventlist, bookings);
+
+    DataIndex index;
+    index.rebuild(Userlist, eventlist, bookings);
+
+    BookingJournal journal;
+    journal.replay(Userlist, eventlist, bookings, index);
+    journal.open();
+
+    #ifdef BOOKING_SHARED
+    SharedInventory inventory;  // outlives the engine, which leaves it
+    #endif
+    BookingEngine engine(eventlist, Userlist, bookings, index, journal);
+
+    #ifdef BOOKING_SHARED
+    if (sharedMode) {
+        if (!inventory.attach(eventlist, engine.nextBookingId)) return 1;
+        engine.shareInventory(inventory);
+        if (inventory.isCreator()) inventory.publish();
+    }
+    #else
+    if (sharedMode) {
+        cerr << "--shared is only supported on Linux\n";
+        return 1;
+    }
+    #endif
+
+    if (argc > 1 && string(argv[1]) == "--script") {
+        return runScript(engine, argc > 2 ? argv[2] : "-");
+    }
+
+    if (argc > 1 && string(argv[1]) == "--import") {
+        return runImport(engine, vector<string>(argv + 2, argv + argc));
+    }
+
+    if (argc > 1 && string(argv[1]) == "--server") {
+        return runServer(engine, argc > 2 ? argv[2] : "9090");
+    }
+
+    int choice;
+    do {
+        engine.syncShared();
+        engine.expireHolds();
+        showScreenHeader("EVENT TICKETING SYSTEM");
+        cout << "1. Register User\n"
+             << "2. View All Events\n"
+             << "3. Book Tickets\n"
+             << "4. Cancel Booking\n"
+             << "5. View My Bookings\n"
+             << "6. Admin Login\n"
+             << "7. Exit\n"
+             << "8. Find Events by Date\n"
+             << "9. Search Events\n";
+        
+        choice = getMenuChoice("Enter your choice: ", 1, 9);
+
+        switch(choice) {
+            case 1: {
+                showScreenHeader("USER REGISTRATION");
+                int UserId = engine.newUserId();
+                cout << "Your User ID: " << UserId <<endl ;
+
+                string UserName = getlineinput("Enter User Name: ");
+                User newUser(UserId, UserName);
+                engine.addUser(newUser);
+                if (!engine.shared) saveUsers(Userlist);
+                
+                cout << "\nUser registered successfully!\n";
+                cout << "\nPress Enter to return...";
+                cin.get();
+                break;
+            }
+            case 2:
+                displayAllEvents(eventlist, "AVAILABLE EVENTS");  // Show compact event list
+                break;
+            case 3:
+                userBookTicket(eventlist, Userlist, engine);
+                break;
+            case 4:
+                cancelBooking(bookings, engine);
+                break;
+            case 5:
+                viewUserBookings(engine, Userlist, eventlist, index);
+                break;
+            case 6:
+                if (!adminlogin()) {
+                    break;  // Just break if login fails (adminlogin() handles the prompt)
+                }
+                adminPanel(eventlist, Userlist, engine);
+                break;
+            case 7:
+                if (!engine.shared) saveUsers(Userlist);
+                engine.checkpoint();
+                cout << "\nExiting program. Goodbye!\n";
+                break;
+            case 8:
+                findEventsByDate(eventlist, index);
+                break;
+            case 9:
+                searchEvents(eventlist, index);
+                break;
+            default:
+                cout << "Invalid choice! Please try again.\n";
+                waitForEnter();
+        }
+    } while (choice != 7);
+
+    return 0;
 }
\ No newline at end of file